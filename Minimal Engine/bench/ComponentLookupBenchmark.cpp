@@ -0,0 +1,95 @@
+// Random-order component lookups through ComponentArray's paged sparse set, compared with the pair of hash maps
+// it replaced. Build with -DMINIMAL_BUILD_BENCHMARKS=ON and run the ComponentLookupBenchmark target.
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "ecs/ComponentArray.hpp"
+
+namespace {
+    using Minimal::Entity;
+
+    struct Payload {
+        float values[4];
+    };
+
+    // The entity/index maps ComponentArray used before the sparse set, with the same swap-and-pop removal
+    class HashMapComponentArray {
+    public:
+        void insertData(Entity entity, const Payload &component) {
+            std::size_t newIndex = m_components.size();
+            m_entityToIndexMap[entity] = newIndex;
+            m_indexToEntityMap[newIndex] = entity;
+            m_components.push_back(component);
+        }
+
+        Payload &getData(Entity entity) {
+            return m_components[m_entityToIndexMap[entity]];
+        }
+
+        bool hasData(Entity entity) const {
+            return m_entityToIndexMap.find(entity) != m_entityToIndexMap.end();
+        }
+
+    private:
+        std::vector<Payload> m_components{};
+        std::unordered_map<Entity, std::size_t> m_entityToIndexMap{};
+        std::unordered_map<std::size_t, Entity> m_indexToEntityMap{};
+    };
+
+    constexpr std::size_t LOOKUPS = 4 * 1024 * 1024;
+
+    // Nanoseconds per hasData + getData pair over the lookup order
+    template<typename Array>
+    double measure(Array &array, const std::vector<Entity> &order) {
+        float sum = 0.0f;
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < LOOKUPS; ++i) {
+            Entity entity = order[i % order.size()];
+            if (array.hasData(entity))
+                sum += array.getData(entity).values[0];
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        // Keeps the loop from being optimized away
+        if (sum < 0.0f)
+            std::printf("%f\n", sum);
+        return std::chrono::duration<double, std::nano>(end - start).count() / LOOKUPS;
+    }
+
+    void run(std::size_t entityCount) {
+        std::vector<Entity> entities(entityCount);
+        for (std::size_t i = 0; i < entityCount; ++i) {
+            entities[i] = Minimal::makeEntity(static_cast<std::uint32_t>(i), 0);
+        }
+
+        Minimal::ComponentArray<Payload> sparseSet;
+        HashMapComponentArray hashMap;
+        for (std::size_t i = 0; i < entityCount; ++i) {
+            Payload payload{{static_cast<float>(i), 0.0f, 0.0f, 0.0f}};
+            sparseSet.insertData(entities[i], payload);
+            hashMap.insertData(entities[i], payload);
+        }
+
+        std::vector<Entity> order(entities);
+        std::shuffle(order.begin(), order.end(), std::mt19937_64(entityCount));
+
+        const double hashMapTime = measure(hashMap, order);
+        const double sparseSetTime = measure(sparseSet, order);
+        std::printf("%8zu entities: unordered_map %6.1f ns, sparse set %6.1f ns\n", entityCount, hashMapTime,
+                    sparseSetTime);
+    }
+}
+
+int main() {
+    for (std::size_t entityCount : {std::size_t{5000}, std::size_t{100000}, std::size_t{1000000}}) {
+        run(entityCount);
+    }
+    return 0;
+}
@@ -5,7 +5,6 @@
 #include "rendering/vulkan/VulkanBuffer.hpp"
 #include "systems/PointLightSystem.hpp"
 #include "systems/SimpleRendererSystem.hpp"
-#include "systems/PhysicsSystem.hpp"
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
@@ -25,13 +24,6 @@ namespace Minimal {
                 .addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VulkanSwapChain::MAX_FRAMES_IN_FLIGHT)
                 .build();
 
-        m_ecs.registerComponent<TransformComponent>();
-        m_ecs.registerComponent<CameraComponent>();
-        m_ecs.registerComponent<MeshRendererComponent>();
-        m_ecs.registerComponent<PointLightComponent>();
-        m_ecs.registerComponent<ColliderComponent>();
-        m_ecs.registerComponent<RigidbodyComponent>();
-
         loadEntities();
     }
 
@@ -69,21 +61,16 @@ namespace Minimal {
             globalSetLayout->getDescriptorSetLayout()
         };
 
-        PointLightSystem pointLightSystem{
-            m_ecs,
+        // Camera, light and physics updates run as tasks of the world, overlapping wherever their access sets allow
+        CameraSystem &cameraSystem = m_world.addSystem<CameraSystem>();
+        PointLightSystem &pointLightSystem = m_world.addSystem<PointLightSystem>(
             m_device,
             m_renderer.getSwapChainRenderPass(),
             globalSetLayout->getDescriptorSetLayout()
-        };
-
-        PhysicsSystem physicsSystem(m_ecs);
+        );
 
         m_scheduler.Startup();
 
-        physicsSystem.initialize();
-
-        CameraSystem cameraSystem{m_ecs};
-
         Entity cameraEntity = m_ecs.createEntity();
         m_ecs.addComponent<CameraComponent>(cameraEntity, {true});
 
@@ -100,7 +87,6 @@ namespace Minimal {
 
         Scheduler::QueueTask([&]()
             {
-				Counter* mainCounter = Scheduler::CreateCounter();
                 while (!m_window.shouldClose()) {
                     glfwPollEvents();
 
@@ -108,7 +94,9 @@ namespace Minimal {
                     float frameTime = std::chrono::duration<float>(newTime - currentTime).count();
                     currentTime = newTime;
 
-                    cameraController.moveInPlaneXZ(m_window.getGlfwWindow(), frameTime, cameraTransform);
+                    // Fetched every frame, sortStorage() below moves components around
+                    cameraController.moveInPlaneXZ(m_window.getGlfwWindow(), frameTime,
+                                                   m_ecs.getComponent<TransformComponent>(cameraEntity));
 
 
                     if (auto commandBuffer = m_renderer.beginFrame()) {
@@ -125,23 +113,7 @@ namespace Minimal {
                             globalDescriptorSets[frameIndex]
                         };
 
-                        /*Scheduler::QueueTask([&]()
-                            {
-                                cameraSystem.update(frameInfo);
-                            }, TaskPriority::HIGH, mainCounter);
-                        Scheduler::QueueTask([&]()
-                            {
-                                pointLightSystem.update(frameInfo);
-                            }, TaskPriority::HIGH, mainCounter);
-                        Scheduler::QueueTask([&]()
-                            {
-                                physicsSystem.update(frameInfo);
-                            }, TaskPriority::HIGH, mainCounter);
-                        Scheduler::WaitForCounter(mainCounter);*/
-
-                        cameraSystem.update(frameInfo);
-                        pointLightSystem.update(frameInfo);
-                        physicsSystem.update(frameInfo);
+                        m_world.update(frameInfo);
 
                         uboBuffers[frameIndex]->writeToBuffer(&frameInfo.ubo);
                         uboBuffers[frameIndex]->flush();
@@ -155,6 +127,10 @@ namespace Minimal {
                         m_renderer.endSwapChainRenderPass(commandBuffer);
                         m_renderer.endFrame();
                     }
+
+                    // Keep nearby entities close in memory, a few thousand comparisons at a time. Runs once the
+                    // frame is done with any component pointers handed out during it.
+                    m_ecs.sortStorage(StorageOrder::Morton, STORAGE_SORT_BUDGET);
                 }
 
                 vkDeviceWaitIdle(m_device.get_device());
@@ -279,7 +255,8 @@ namespace Minimal {
         auto cube = m_ecs.createEntity();
         m_ecs.addComponent<MeshRendererComponent>(cube, {mesh});
         m_ecs.addComponent<ColliderComponent>(cube, { EColliderType::Box, glm::vec3(0, 0, 0), glm::vec3(2.5f, 0.5f, 2.5f) });
-        m_ecs.addComponent<RigidbodyComponent>(cube, { false, 1000, 0, 0.5f, 0.3f, glm::vec3(0, 0.0f, 0), glm::vec3(0, 0.0f, 0), glm::vec3(0, 0.0f, 0) });
+        m_ecs.addComponent<RigidbodyPropertiesComponent>(cube, { false, 1000, 0, 0.5f, 0.3f, glm::vec3(0, 0.0f, 0) });
+        m_ecs.addComponent<RigidbodyComponent>(cube, { glm::vec3(0, 0.0f, 0), glm::vec3(0, 0.0f, 0) });
         auto &cubeTransform = m_ecs.getComponent<TransformComponent>(cube);
         cubeTransform.position = {0.0f, -2.0f, 0.0f};
         cubeTransform.scale = {5.0f, 1.5f, 5.0f};
@@ -294,10 +271,16 @@ namespace Minimal {
             {1.0f, 1.0f, 1.0f}
         };
 
+        std::vector<Entity> pointLights(lightColors.size());
+        std::vector<PointLightComponent> pointLightComponents;
+        for (const glm::vec3 &color : lightColors)
+            pointLightComponents.push_back({0.2f, color});
+
+        m_ecs.createEntities(pointLights.size(), pointLights.data());
+        m_ecs.addComponents<PointLightComponent>(pointLights.data(), pointLightComponents.data(), pointLights.size());
+
         for (int i = 0; i < lightColors.size(); i++) {
-            auto pointLight = m_ecs.createEntity();
-            m_ecs.addComponent<PointLightComponent>(pointLight, {0.2f, lightColors[i]});
-            auto &pointLightTransform = m_ecs.getComponent<TransformComponent>(pointLight);
+            auto &pointLightTransform = m_ecs.getComponent<TransformComponent>(pointLights[i]);
             pointLightTransform.scale.x = 0.1f;
             auto rotateLight = rotate(glm::mat4(1.0f),
                                       i * glm::two_pi<float>() / lightColors.size(),
@@ -307,15 +290,20 @@ namespace Minimal {
 
         /* Physics objects */
         {
-            auto object = m_ecs.createEntity();
-            m_ecs.addComponent<MeshRendererComponent>(object, { mesh });
-            m_ecs.addComponent<ColliderComponent>(object, { EColliderType::Box, glm::vec3(0, 0, 0), glm::vec3(0.5f, 0.5f, 0.5f) });
-            m_ecs.addComponent<RigidbodyComponent>(object, { false, 1, 0, 0.5f, 0.3f, glm::vec3(0, -1.8f, 0), glm::vec3(0, 0.0f, 0), glm::vec3(0, 0.0f, 0) });
-
-            auto& transform = m_ecs.getComponent<TransformComponent>(object);
+            TransformComponent transform{};
             transform.position = { 0.0f, 0.0f, 0.0f };
             transform.rotate(glm::quat(glm::vec3(0, 0, 1.0f)));
             transform.scale = { 0.5f, 0.5f, 0.5f };
+
+            Prefab physicsCube;
+            physicsCube.set<TransformComponent>(transform)
+                    .set<MeshRendererComponent>({ mesh })
+                    .set<ColliderComponent>({ EColliderType::Box, glm::vec3(0, 0, 0), glm::vec3(0.5f, 0.5f, 0.5f) })
+                    .set<RigidbodyPropertiesComponent>({ false, 1, 0, 0.5f, 0.3f, glm::vec3(0, -1.8f, 0) })
+                    .set<RigidbodyComponent>({ glm::vec3(0, 0.0f, 0), glm::vec3(0, 0.0f, 0) });
+
+            Entity object;
+            m_ecs.instantiate(physicsCube, 1, &object);
         }
     }
 }
@@ -3,6 +3,7 @@
 #include <memory>
 
 #include "Window.hpp"
+#include "World.hpp"
 #include "ecs/ECSCoordinator.hpp"
 #include "rendering/vulkan/VulkanDescriptors.hpp"
 #include "rendering/vulkan/VulkanDevice.hpp"
@@ -14,6 +15,8 @@ namespace Minimal {
     public:
         static constexpr int WIDTH = 800;
         static constexpr int HEIGHT = 600;
+        // Comparisons per frame spent on keeping component storage in Morton order
+        static constexpr std::size_t STORAGE_SORT_BUDGET = 4096;
 
         /**
          * Constructor for the Engine class.
@@ -39,7 +42,8 @@ namespace Minimal {
         // note: order of declarations matters
         std::unique_ptr<VulkanDescriptorPool> m_globalPool{};
 
-        ECSCoordinator m_ecs{};
+        World m_world{StorageMode::Archetype};
+        ECSCoordinator &m_ecs = m_world.getECS();
         Scheduler m_scheduler{};
     };
 }
@@ -0,0 +1,61 @@
+#include "World.hpp"
+
+#include "ecs/Components.hpp"
+#include "scheduler/Scheduler.h"
+#include "systems/PhysicsSystem.hpp"
+#include "systems/TransformSystem.hpp"
+
+namespace Minimal {
+    World::World(StorageMode storageMode)
+        : m_ecs(storageMode) {
+        m_ecs.registerComponent<TransformComponent>();
+        m_ecs.registerComponent<CameraComponent>();
+        m_ecs.registerComponent<MeshRendererComponent>();
+        m_ecs.registerComponent<PointLightComponent>();
+        m_ecs.registerComponent<ColliderComponent>();
+        m_ecs.registerComponent<RigidbodyComponent>();
+        m_ecs.registerComponent<RigidbodyPropertiesComponent>();
+        m_ecs.registerComponent<HierarchyComponent>();
+        m_ecs.registerComponent<WorldTransformComponent>();
+
+        addSystem<PhysicsSystem>();
+        // Runs after physics moved the bodies
+        addSystem<TransformSystem>();
+    }
+
+    World::~World() = default;
+
+    void World::update(FrameInfo &frameInfo) {
+        m_frameIndex = frameInfo.frameIndex;
+        m_systemGraph.update(frameInfo);
+    }
+
+    void World::step(float deltaTime) {
+        FrameInfo frameInfo{
+            m_frameIndex + 1,
+            deltaTime,
+            VK_NULL_HANDLE,
+            1.0f,
+            {},
+            nullptr,
+            VK_NULL_HANDLE
+        };
+
+        update(frameInfo);
+    }
+
+    void World::stepAll(World *const *worlds, std::size_t count, float deltaTime) {
+        if (count == 0)
+            return;
+
+        // Medium priority so the system tasks of worlds already being stepped go ahead of starting new ones
+        Counter *counter = Scheduler::CreateCounter();
+        for (std::size_t i = 0; i < count; ++i) {
+            World *world = worlds[i];
+            Scheduler::QueueTask([world, deltaTime]() { world->step(deltaTime); }, TaskPriority::MEDIUM, counter);
+        }
+
+        Scheduler::WaitForCounter(counter);
+        Scheduler::DestroyCounter(counter);
+    }
+}
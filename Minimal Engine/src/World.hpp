@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "FrameInfo.hpp"
+#include "ecs/ECSCoordinator.hpp"
+#include "systems/System.hpp"
+#include "systems/SystemGraph.hpp"
+
+namespace Minimal {
+    // An ECS together with the systems that update it. Worlds share no mutable state, every system keeps its
+    // simulation state as members, so any number of them can be stepped at the same time on different threads.
+    // A new world has the engine's components registered and a PhysicsSystem and TransformSystem added.
+    class World {
+    public:
+        explicit World(StorageMode storageMode = StorageMode::Archetype);
+
+        ~World();
+
+        World(const World &) = delete;
+
+        World &operator=(const World &) = delete;
+
+        // Constructs a system updating this world, it runs after the systems added before it that it conflicts with.
+        template<typename T, typename... Args>
+        T &addSystem(Args &&... args) {
+            auto system = std::make_unique<T>(m_ecs, std::forward<Args>(args)...);
+            T &result = *system;
+            m_systems.push_back(std::move(system));
+            m_systemGraph.addSystem(result);
+            return result;
+        }
+
+        ECSCoordinator &getECS() { return m_ecs; }
+
+        // Updates every system with the given frame. Must be called from a scheduler task.
+        void update(FrameInfo &frameInfo);
+
+        // Advances the world by deltaTime without rendering. Must be called from a scheduler task.
+        void step(float deltaTime);
+
+        // Steps count worlds concurrently, one task each, and returns once all of them are done. Must be called
+        // from a scheduler task.
+        static void stepAll(World *const *worlds, std::size_t count, float deltaTime);
+
+    private:
+        // note: order of declarations matters, the graph and systems refer to the ECS
+        ECSCoordinator m_ecs;
+        std::vector<std::unique_ptr<System> > m_systems{};
+        SystemGraph m_systemGraph{m_ecs};
+
+        int m_frameIndex = 0;
+    };
+}
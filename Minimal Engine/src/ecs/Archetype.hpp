@@ -0,0 +1,341 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "EntityManager.hpp"
+#include "TagComponent.hpp"
+
+namespace Minimal {
+    // Size of a single archetype chunk in bytes. Every chunk holds one column per component type
+    // of its archetype, so rows of the same archetype are streamed linearly per component.
+    constexpr std::size_t ARCHETYPE_CHUNK_SIZE = 16 * 1024;
+    // Chunks and every column inside them start on this boundary, so columns never share a cache line and
+    // vectorized loops can use aligned loads from the first row on.
+    constexpr std::size_t ARCHETYPE_CHUNK_ALIGNMENT = 64;
+
+    // Type-erased operations needed to move component values between archetype columns.
+    struct ComponentTypeInfo {
+        std::size_t size = 0;
+        std::size_t alignment = 0;
+        // Tags are part of an archetype's signature but get no column
+        bool isTag = false;
+
+        // Move-constructs dst from src and destroys src.
+        void (*relocate)(void *dst, void *src) = nullptr;
+        void (*destroy)(void *ptr) = nullptr;
+        void (*swap)(void *a, void *b) = nullptr;
+        // Copy-constructs count consecutive values at dst from value.
+        void (*fill)(void *dst, const void *value, std::size_t count) = nullptr;
+
+        template<typename T>
+        static ComponentTypeInfo create() {
+            ComponentTypeInfo info{};
+            info.size = sizeof(T);
+            info.alignment = alignof(T);
+            info.isTag = isTagComponent<T>;
+            info.relocate = [](void *dst, void *src) {
+                T *source = static_cast<T *>(src);
+                new(dst) T(std::move(*source));
+                source->~T();
+            };
+            info.destroy = [](void *ptr) {
+                static_cast<T *>(ptr)->~T();
+            };
+            info.swap = [](void *a, void *b) {
+                using std::swap;
+                swap(*static_cast<T *>(a), *static_cast<T *>(b));
+            };
+            info.fill = [](void *dst, const void *value, std::size_t count) {
+                if constexpr (std::is_trivially_copyable_v<T>) {
+                    // Copies the rows filled so far onto the rest, doubling the copied block every step
+                    if (count == 0)
+                        return;
+                    std::byte *bytes = static_cast<std::byte *>(dst);
+                    std::memcpy(bytes, value, sizeof(T));
+                    for (std::size_t filled = 1; filled < count; filled *= 2) {
+                        std::memcpy(bytes + filled * sizeof(T), bytes, std::min(filled, count - filled) * sizeof(T));
+                    }
+                } else {
+                    std::uninitialized_fill_n(static_cast<T *>(dst), count, *static_cast<const T *>(value));
+                }
+            };
+            return info;
+        }
+    };
+
+    struct alignas(ARCHETYPE_CHUNK_ALIGNMENT) ArchetypeChunk {
+        std::byte data[ARCHETYPE_CHUNK_SIZE];
+    };
+
+    class Archetype {
+    public:
+        static constexpr std::int16_t NO_COLUMN = -1;
+
+        Archetype(const Signature &signature, const std::vector<const ComponentTypeInfo *> &typeInfos)
+            : m_signature(signature) {
+            m_columnIndices.fill(NO_COLUMN);
+            for (ComponentType type = 0; type < MAX_COMPONENTS; ++type) {
+                if (!signature.test(type))
+                    continue;
+
+                assert(typeInfos[type] != nullptr && "Component not registered before use.");
+                if (typeInfos[type]->isTag)
+                    continue;
+
+                m_columnIndices[type] = static_cast<std::int16_t>(m_columnTypes.size());
+                m_columnTypes.push_back(type);
+                m_columnInfos.push_back(typeInfos[type]);
+            }
+
+            computeLayout();
+        }
+
+        ~Archetype() {
+            for (std::size_t row = 0; row < m_size; ++row) {
+                for (std::size_t column = 0; column < m_columnInfos.size(); ++column) {
+                    m_columnInfos[column]->destroy(columnAt(column, row));
+                }
+            }
+        }
+
+        Archetype(const Archetype &) = delete;
+
+        Archetype &operator=(const Archetype &) = delete;
+
+        const Signature &getSignature() const { return m_signature; }
+
+        bool hasComponent(ComponentType type) const { return m_signature.test(type); }
+
+        // False for tags, which are only recorded in the signature.
+        bool hasColumn(ComponentType type) const { return m_columnIndices[type] != NO_COLUMN; }
+
+        // Reserves an uninitialized row at the end of the archetype. The caller is expected to construct
+        // every column of the returned row before the archetype is used again.
+        std::size_t allocateRow(Entity entity) {
+            std::size_t row = m_size;
+            std::size_t chunkIndex = row / m_chunkCapacity;
+            if (chunkIndex == m_chunks.size()) {
+                m_chunks.push_back(std::make_unique<ArchetypeChunk>());
+                m_chunkVersions.resize(m_chunks.size() * m_columnTypes.size(), 0);
+            }
+
+            entitiesOf(chunkIndex)[row % m_chunkCapacity] = entity;
+            ++m_size;
+            return row;
+        }
+
+        // Reserves count uninitialized rows at the end of the archetype for the given entities and returns the
+        // first of them. The caller constructs every column of them, e.g. through fillRows().
+        std::size_t allocateRows(const Entity *entities, std::size_t count) {
+            const std::size_t first = m_size;
+            const std::size_t chunksNeeded = (first + count + m_chunkCapacity - 1) / m_chunkCapacity;
+            while (m_chunks.size() < chunksNeeded) {
+                m_chunks.push_back(std::make_unique<ArchetypeChunk>());
+            }
+            m_chunkVersions.resize(m_chunks.size() * m_columnTypes.size(), 0);
+
+            for (std::size_t copied = 0; copied < count;) {
+                const std::size_t row = first + copied;
+                const std::size_t run = std::min(count - copied, m_chunkCapacity - row % m_chunkCapacity);
+                std::copy_n(entities + copied, run, entitiesOf(row / m_chunkCapacity) + row % m_chunkCapacity);
+                copied += run;
+            }
+            m_size += count;
+            return first;
+        }
+
+        // Copy-constructs the component of count rows starting at first from value, one block per chunk,
+        // and stamps the chunks as changed at the given version.
+        void fillRows(ComponentType type, std::size_t first, std::size_t count, const void *value,
+                      std::uint32_t version) {
+            assert(hasColumn(type) && "Archetype does not contain component.");
+            assert(first + count <= m_size && "Row out of range.");
+
+            const std::size_t column = m_columnIndices[type];
+            for (std::size_t filled = 0; filled < count;) {
+                const std::size_t row = first + filled;
+                const std::size_t run = std::min(count - filled, m_chunkCapacity - row % m_chunkCapacity);
+                m_columnInfos[column]->fill(columnAt(column, row), value, run);
+                std::uint32_t &current = chunkVersion(row / m_chunkCapacity, column);
+                current = std::max(current, version);
+                filled += run;
+            }
+        }
+
+        // Destroys every component of the row and compacts the archetype.
+        // Returns the entity that was moved into the row, or the removed entity if it was the last row.
+        Entity removeRow(std::size_t row) {
+            for (std::size_t column = 0; column < m_columnInfos.size(); ++column) {
+                m_columnInfos[column]->destroy(columnAt(column, row));
+            }
+            return fillHole(row);
+        }
+
+        // Moves the last row into an already destroyed or relocated row so the chunks stay densely packed.
+        // Returns the entity that was moved into the row, or the entity of the row if it was the last one.
+        Entity fillHole(std::size_t row) {
+            assert(row < m_size && "Row out of range.");
+
+            std::size_t lastRow = m_size - 1;
+            Entity movedEntity = entityAt(lastRow);
+            if (row != lastRow) {
+                const std::size_t chunk = row / m_chunkCapacity;
+                const std::size_t lastChunk = lastRow / m_chunkCapacity;
+                for (std::size_t column = 0; column < m_columnInfos.size(); ++column) {
+                    m_columnInfos[column]->relocate(columnAt(column, row), columnAt(column, lastRow));
+                    // The moved row carries its change versions into the destination chunk
+                    std::uint32_t &version = chunkVersion(chunk, column);
+                    version = std::max(version, chunkVersion(lastChunk, column));
+                }
+                entitiesOf(chunk)[row % m_chunkCapacity] = movedEntity;
+            }
+
+            --m_size;
+            return movedEntity;
+        }
+
+        // Exchanges the components and entities of two rows. Rows in different chunks carry their change versions
+        // over by raising both chunks to the higher version, which may report unchanged rows as changed.
+        void swapRows(std::size_t a, std::size_t b) {
+            assert(a < m_size && b < m_size && "Row out of range.");
+
+            const std::size_t chunkA = a / m_chunkCapacity;
+            const std::size_t chunkB = b / m_chunkCapacity;
+            for (std::size_t column = 0; column < m_columnInfos.size(); ++column) {
+                m_columnInfos[column]->swap(columnAt(column, a), columnAt(column, b));
+                if (chunkA != chunkB) {
+                    const std::uint32_t version = std::max(chunkVersion(chunkA, column), chunkVersion(chunkB, column));
+                    chunkVersion(chunkA, column) = version;
+                    chunkVersion(chunkB, column) = version;
+                }
+            }
+            std::swap(entitiesOf(chunkA)[a % m_chunkCapacity], entitiesOf(chunkB)[b % m_chunkCapacity]);
+        }
+
+        void *componentAt(ComponentType type, std::size_t row) {
+            assert(hasColumn(type) && "Archetype does not contain component.");
+            return columnAt(m_columnIndices[type], row);
+        }
+
+        Entity entityAt(std::size_t row) {
+            return entitiesOf(row / m_chunkCapacity)[row % m_chunkCapacity];
+        }
+
+        std::size_t size() const { return m_size; }
+
+        std::size_t chunkCapacity() const { return m_chunkCapacity; }
+
+        std::size_t chunkCount() const { return (m_size + m_chunkCapacity - 1) / m_chunkCapacity; }
+
+        std::size_t chunkSize(std::size_t chunkIndex) const {
+            std::size_t begin = chunkIndex * m_chunkCapacity;
+            return m_size - begin < m_chunkCapacity ? m_size - begin : m_chunkCapacity;
+        }
+
+        std::size_t chunkOf(std::size_t row) const { return row / m_chunkCapacity; }
+
+        // Highest change version written to the component column of a chunk. Changes are tracked per chunk,
+        // so a change to any row marks the whole chunk as changed.
+        std::uint32_t getChunkVersion(std::size_t chunkIndex, ComponentType type) const {
+            assert(hasColumn(type) && "Archetype does not contain component.");
+            return m_chunkVersions[chunkIndex * m_columnTypes.size() + m_columnIndices[type]];
+        }
+
+        void markChunkChanged(std::size_t chunkIndex, ComponentType type, std::uint32_t version) {
+            assert(hasColumn(type) && "Archetype does not contain component.");
+            std::uint32_t &current = chunkVersion(chunkIndex, m_columnIndices[type]);
+            current = std::max(current, version);
+        }
+
+        Entity *entitiesOf(std::size_t chunkIndex) {
+            return reinterpret_cast<Entity *>(m_chunks[chunkIndex]->data);
+        }
+
+        template<typename T>
+        T *columnOf(std::size_t chunkIndex, ComponentType type) {
+            assert(hasColumn(type) && "Archetype does not contain component.");
+            std::size_t offset = m_columnOffsets[m_columnIndices[type]];
+            return std::launder(reinterpret_cast<T *>(m_chunks[chunkIndex]->data + offset));
+        }
+
+        // Cached transitions to the archetypes reached by adding or removing a single component type.
+        Archetype *getAddEdge(ComponentType type) const { return m_addEdges[type]; }
+        Archetype *getRemoveEdge(ComponentType type) const { return m_removeEdges[type]; }
+        void setAddEdge(ComponentType type, Archetype *archetype) { m_addEdges[type] = archetype; }
+        void setRemoveEdge(ComponentType type, Archetype *archetype) { m_removeEdges[type] = archetype; }
+
+    private:
+        void computeLayout() {
+            std::size_t rowSize = sizeof(Entity);
+            for (const ComponentTypeInfo *info : m_columnInfos) {
+                rowSize += info->size;
+            }
+
+            // Start from the optimistic capacity and shrink until alignment padding fits in the chunk
+            m_chunkCapacity = ARCHETYPE_CHUNK_SIZE / rowSize;
+            assert(m_chunkCapacity > 0 && "Archetype row does not fit in a single chunk.");
+            while (layoutSize(m_chunkCapacity) > ARCHETYPE_CHUNK_SIZE) {
+                --m_chunkCapacity;
+            }
+
+            m_columnOffsets.resize(m_columnInfos.size());
+            std::size_t offset = sizeof(Entity) * m_chunkCapacity;
+            for (std::size_t column = 0; column < m_columnInfos.size(); ++column) {
+                offset = alignUp(offset, columnAlignment(*m_columnInfos[column]));
+                m_columnOffsets[column] = offset;
+                offset += m_columnInfos[column]->size * m_chunkCapacity;
+            }
+        }
+
+        std::size_t layoutSize(std::size_t capacity) const {
+            std::size_t offset = sizeof(Entity) * capacity;
+            for (const ComponentTypeInfo *info : m_columnInfos) {
+                offset = alignUp(offset, columnAlignment(*info)) + info->size * capacity;
+            }
+            return offset;
+        }
+
+        static std::size_t columnAlignment(const ComponentTypeInfo &info) {
+            return std::max(info.alignment, ARCHETYPE_CHUNK_ALIGNMENT);
+        }
+
+        static std::size_t alignUp(std::size_t value, std::size_t alignment) {
+            return (value + alignment - 1) & ~(alignment - 1);
+        }
+
+        std::uint32_t &chunkVersion(std::size_t chunkIndex, std::size_t column) {
+            return m_chunkVersions[chunkIndex * m_columnTypes.size() + column];
+        }
+
+        void *columnAt(std::size_t column, std::size_t row) {
+            std::size_t chunkIndex = row / m_chunkCapacity;
+            std::size_t localRow = row % m_chunkCapacity;
+            return m_chunks[chunkIndex]->data + m_columnOffsets[column] + localRow * m_columnInfos[column]->size;
+        }
+
+        Signature m_signature;
+        std::vector<ComponentType> m_columnTypes{};
+        std::vector<const ComponentTypeInfo *> m_columnInfos{};
+        std::vector<std::size_t> m_columnOffsets{};
+        std::array<std::int16_t, MAX_COMPONENTS> m_columnIndices{};
+
+        std::vector<std::unique_ptr<ArchetypeChunk> > m_chunks{};
+        // One change version per chunk and column, laid out chunk by chunk
+        std::vector<std::uint32_t> m_chunkVersions{};
+        std::size_t m_chunkCapacity = 0;
+        std::size_t m_size = 0;
+
+        std::array<Archetype *, MAX_COMPONENTS> m_addEdges{};
+        std::array<Archetype *, MAX_COMPONENTS> m_removeEdges{};
+    };
+}
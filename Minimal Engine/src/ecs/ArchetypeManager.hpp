@@ -0,0 +1,357 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "Archetype.hpp"
+#include "ComponentTypeId.hpp"
+#include "StorageOrder.hpp"
+
+namespace Minimal {
+    // Stores components grouped by entity signature. Entities sharing a signature live in the same archetype,
+    // packed into fixed-size chunks with one contiguous column per component type.
+    class ArchetypeManager {
+    public:
+        ArchetypeManager() {
+            m_typeInfos.resize(MAX_COMPONENTS, nullptr);
+        }
+
+        template<typename T>
+        void registerComponent() {
+            ComponentType type = componentTypeId<T>();
+
+            assert(m_typeInfos[type] == nullptr && "Registering component type more than once.");
+
+            m_registeredTypes.push_back(std::make_unique<ComponentTypeInfo>(ComponentTypeInfo::create<T>()));
+            m_typeInfos[type] = m_registeredTypes.back().get();
+        }
+
+        template<typename T>
+        void addComponent(Entity entity, const T &component) {
+            ComponentType type = getComponentType<T>();
+            EntityRecord &record = getRecord(entity);
+
+            assert((record.archetype == nullptr || !record.archetype->hasComponent(type))
+                && "Component added to same entity more than once.");
+
+            Archetype *target = getAddTarget(record.archetype, type);
+            std::size_t row = target->allocateRow(entity);
+            if constexpr (!isTagComponent<T>)
+                new(target->componentAt(type, row)) T(component);
+
+            moveEntity(entity, record, target, row);
+        }
+
+        // Adds one component per entity. Consecutive entities coming from the same archetype reuse the
+        // resolved target, so a batch of freshly created entities resolves its archetype only once.
+        template<typename T>
+        void addComponents(const Entity *entities, const T *components, std::size_t count) {
+            ComponentType type = getComponentType<T>();
+            Archetype *source = nullptr;
+            Archetype *target = nullptr;
+            for (std::size_t i = 0; i < count; ++i) {
+                EntityRecord &record = getRecord(entities[i]);
+                assert((record.archetype == nullptr || !record.archetype->hasComponent(type))
+                    && "Component added to same entity more than once.");
+
+                if (target == nullptr || record.archetype != source) {
+                    source = record.archetype;
+                    target = getAddTarget(source, type);
+                }
+
+                std::size_t row = target->allocateRow(entities[i]);
+                if constexpr (!isTagComponent<T>)
+                    new(target->componentAt(type, row)) T(components[i]);
+                moveEntity(entities[i], record, target, row);
+            }
+        }
+
+        // Places count entities that have no components yet into the archetype of the given signature. Their rows
+        // are appended as one block and every column is filled with copies of values[type], stamped as changed at
+        // the given version.
+        void instantiate(const Signature &signature, const void *const *values, const Entity *entities,
+                         std::size_t count, std::uint32_t version) {
+            Archetype *target = getOrCreateArchetype(signature);
+            const std::size_t first = target->allocateRows(entities, count);
+            for (ComponentType type = 0; type < MAX_COMPONENTS; ++type) {
+                if (target->hasColumn(type))
+                    target->fillRows(type, first, count, values[type], version);
+            }
+
+            for (std::size_t i = 0; i < count; ++i) {
+                EntityRecord &record = getRecord(entities[i]);
+                assert(record.archetype == nullptr && "Instantiating into an entity that already has components.");
+                record.archetype = target;
+                record.row = first + i;
+            }
+        }
+
+        template<typename T>
+        void removeComponent(Entity entity) {
+            ComponentType type = getComponentType<T>();
+            EntityRecord &record = getRecord(entity);
+
+            assert(record.archetype != nullptr && record.archetype->hasComponent(type)
+                && "Removing non-existent component.");
+
+            Archetype *source = record.archetype;
+            std::size_t sourceRow = record.row;
+            if constexpr (!isTagComponent<T>)
+                m_typeInfos[type]->destroy(source->componentAt(type, sourceRow));
+
+            Archetype *target = getRemoveTarget(source, type);
+            if (target == nullptr) {
+                // Last component of the entity, nothing left to move
+                Entity moved = source->fillHole(sourceRow);
+                if (moved != entity)
+                    m_records[entityIndex(moved)].row = sourceRow;
+                record = {};
+                return;
+            }
+
+            std::size_t row = target->allocateRow(entity);
+            moveEntity(entity, record, target, row);
+        }
+
+        template<typename T>
+        T &getComponent(Entity entity) {
+            ComponentType type = getComponentType<T>();
+            EntityRecord &record = getRecord(entity);
+
+            assert(record.archetype != nullptr && record.archetype->hasComponent(type)
+                && "Retrieving non-existent component.");
+            if constexpr (isTagComponent<T>)
+                return tagInstance<T>();
+            else
+                return *static_cast<T *>(record.archetype->componentAt(type, record.row));
+        }
+
+        template<typename T>
+        bool hasComponent(Entity entity) {
+            if (entityIndex(entity) >= m_records.size())
+                return false;
+
+            const EntityRecord &record = m_records[entityIndex(entity)];
+            return record.archetype != nullptr && record.archetype->hasComponent(getComponentType<T>());
+        }
+
+        void destroyEntity(Entity entity) {
+            if (entityIndex(entity) >= m_records.size())
+                return;
+
+            EntityRecord &record = m_records[entityIndex(entity)];
+            if (record.archetype == nullptr)
+                return;
+
+            Entity moved = record.archetype->removeRow(record.row);
+            if (moved != entity)
+                m_records[entityIndex(moved)].row = record.row;
+            record = {};
+        }
+
+        // Mutable access that stamps the entity's chunk as changed for T at the given version.
+        template<typename T>
+        T &writeComponent(Entity entity, std::uint32_t version) {
+            if constexpr (!isTagComponent<T>)
+                markChanged(entity, getComponentType<T>(), version);
+            return getComponent<T>(entity);
+        }
+
+        void markChanged(Entity entity, ComponentType type, std::uint32_t version) {
+            const EntityRecord &record = m_records[entityIndex(entity)];
+            record.archetype->markChunkChanged(record.archetype->chunkOf(record.row), type, version);
+        }
+
+        // Change version of the chunk holding the entity's component.
+        std::uint32_t getChangeVersion(Entity entity, ComponentType type) const {
+            const EntityRecord &record = m_records[entityIndex(entity)];
+            return record.archetype->getChunkVersion(record.archetype->chunkOf(record.row), type);
+        }
+
+        // Untyped access for callers that already resolved the component type, e.g. views.
+        void *getComponentData(Entity entity, ComponentType type) {
+            const EntityRecord &record = m_records[entityIndex(entity)];
+            return record.archetype->componentAt(type, record.row);
+        }
+
+        // Archetypes whose signature contains every one of Ts.
+        template<typename... Ts>
+        std::vector<Archetype *> getMatchingArchetypes() const {
+            Signature required{};
+            (required.set(getComponentType<Ts>()), ...);
+
+            std::vector<Archetype *> matching;
+            for (const auto &archetype : m_archetypes) {
+                if ((archetype->getSignature() & required) == required)
+                    matching.push_back(archetype.get());
+            }
+            return matching;
+        }
+
+        // Registers a list that is kept up to date with every archetype whose signature contains the given one.
+        // Archetypes are never destroyed, so the list only grows when a matching archetype is first created.
+        void registerQuery(std::vector<Archetype *> &archetypes, const Signature &signature) {
+            assert(findQuery(archetypes) == m_queries.end() && "Registering query more than once.");
+
+            archetypes.clear();
+            for (const auto &archetype : m_archetypes) {
+                if ((archetype->getSignature() & signature) == signature)
+                    archetypes.push_back(archetype.get());
+            }
+            m_queries.push_back({signature, &archetypes});
+        }
+
+        void unregisterQuery(std::vector<Archetype *> &archetypes) {
+            auto it = findQuery(archetypes);
+            assert(it != m_queries.end() && "Unregistering unknown query.");
+            m_queries.erase(it);
+        }
+
+        template<typename T>
+        ComponentType getComponentType() const {
+            ComponentType type = componentTypeId<T>();
+            assert(m_typeInfos[type] != nullptr && "Component not registered before use.");
+            return type;
+        }
+
+        // Moves the rows of every archetype a step closer to ascending keyOf(entity) order, comparing at most
+        // budget pairs of rows in total. Archetypes are visited round-robin, each one until it is
+        // sorted or the budget runs out. Returns the number of comparisons made.
+        template<typename KeyOf>
+        std::size_t sortStorage(std::size_t budget, KeyOf &&keyOf) {
+            m_sorters.resize(m_archetypes.size());
+
+            std::size_t steps = 0;
+            for (std::size_t visited = 0; visited < m_archetypes.size() && steps < budget; ++visited) {
+                m_sortCursor %= m_archetypes.size();
+                Archetype &archetype = *m_archetypes[m_sortCursor];
+                const std::size_t remaining = budget - steps;
+                const std::size_t taken = m_sorters[m_sortCursor].run(
+                    archetype.size(), remaining,
+                    [&](std::size_t row) { return keyOf(archetype.entityAt(row)); },
+                    [&](std::size_t a, std::size_t b) {
+                        archetype.swapRows(a, b);
+                        m_records[entityIndex(archetype.entityAt(a))].row = a;
+                        m_records[entityIndex(archetype.entityAt(b))].row = b;
+                    });
+                steps += taken;
+                // Out of budget midway, carry on with the same archetype next time
+                if (taken == remaining)
+                    break;
+                ++m_sortCursor;
+            }
+            return steps;
+        }
+
+    private:
+        struct EntityRecord {
+            Archetype *archetype = nullptr;
+            std::size_t row = 0;
+        };
+
+        EntityRecord &getRecord(Entity entity) {
+            if (entityIndex(entity) >= m_records.size())
+                m_records.resize(static_cast<std::size_t>(entityIndex(entity)) + 1);
+            return m_records[entityIndex(entity)];
+        }
+
+        Archetype *getOrCreateArchetype(const Signature &signature) {
+            auto it = m_archetypesBySignature.find(signature);
+            if (it != m_archetypesBySignature.end())
+                return it->second;
+
+            m_archetypes.push_back(std::make_unique<Archetype>(signature, m_typeInfos));
+            Archetype *archetype = m_archetypes.back().get();
+            m_archetypesBySignature[signature] = archetype;
+            for (const QueryRecord &query : m_queries) {
+                if ((signature & query.signature) == query.signature)
+                    query.archetypes->push_back(archetype);
+            }
+            return archetype;
+        }
+
+        struct QueryRecord {
+            Signature signature;
+            std::vector<Archetype *> *archetypes;
+        };
+
+        std::vector<QueryRecord>::iterator findQuery(const std::vector<Archetype *> &archetypes) {
+            return std::find_if(m_queries.begin(), m_queries.end(), [&archetypes](const QueryRecord &query) {
+                return query.archetypes == &archetypes;
+            });
+        }
+
+        Archetype *getAddTarget(Archetype *source, ComponentType type) {
+            if (source == nullptr) {
+                Signature signature{};
+                signature.set(type);
+                return getOrCreateArchetype(signature);
+            }
+
+            Archetype *target = source->getAddEdge(type);
+            if (target == nullptr) {
+                target = getOrCreateArchetype(Signature(source->getSignature()).set(type));
+                source->setAddEdge(type, target);
+                target->setRemoveEdge(type, source);
+            }
+            return target;
+        }
+
+        Archetype *getRemoveTarget(Archetype *source, ComponentType type) {
+            Signature signature = Signature(source->getSignature()).reset(type);
+            if (signature.none())
+                return nullptr;
+
+            Archetype *target = source->getRemoveEdge(type);
+            if (target == nullptr) {
+                target = getOrCreateArchetype(signature);
+                source->setRemoveEdge(type, target);
+                target->setAddEdge(type, source);
+            }
+            return target;
+        }
+
+        // Relocates every column shared by the entity's current archetype and the target, then compacts the source.
+        // Columns that only exist in the target must already be constructed, columns that only exist in the
+        // source must already be destroyed.
+        void moveEntity(Entity entity, EntityRecord &record, Archetype *target, std::size_t targetRow) {
+            Archetype *source = record.archetype;
+            if (source != nullptr) {
+                const Signature shared = source->getSignature() & target->getSignature();
+                const std::size_t sourceChunk = source->chunkOf(record.row);
+                const std::size_t targetChunk = target->chunkOf(targetRow);
+                for (ComponentType type = 0; type < MAX_COMPONENTS; ++type) {
+                    if (!shared.test(type) || !target->hasColumn(type))
+                        continue;
+                    m_typeInfos[type]->relocate(target->componentAt(type, targetRow),
+                                                source->componentAt(type, record.row));
+                    target->markChunkChanged(targetChunk, type, source->getChunkVersion(sourceChunk, type));
+                }
+
+                Entity moved = source->fillHole(record.row);
+                if (moved != entity)
+                    m_records[entityIndex(moved)].row = record.row;
+            }
+
+            record.archetype = target;
+            record.row = targetRow;
+        }
+
+        std::vector<std::unique_ptr<ComponentTypeInfo> > m_registeredTypes{};
+        std::vector<const ComponentTypeInfo *> m_typeInfos{};
+
+        std::vector<std::unique_ptr<Archetype> > m_archetypes{};
+        std::unordered_map<Signature, Archetype *> m_archetypesBySignature{};
+        std::vector<EntityRecord> m_records{};
+
+        // Archetype lists registered through registerQuery
+        std::vector<QueryRecord> m_queries{};
+
+        // Progress of sortStorage, parallel to m_archetypes
+        std::vector<IncrementalSorter> m_sorters{};
+        std::size_t m_sortCursor = 0;
+    };
+}
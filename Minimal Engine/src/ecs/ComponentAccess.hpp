@@ -0,0 +1,29 @@
+#pragma once
+
+#include "ComponentTypeId.hpp"
+#include "EntityManager.hpp"
+
+namespace Minimal {
+    // Component types a task reads and writes while it runs. Tasks whose write sets do not overlap any other
+    // task's read or write set can run at the same time.
+    struct ComponentAccess {
+        Signature reads{};
+        Signature writes{};
+
+        template<typename... Ts>
+        ComponentAccess &read() {
+            (reads.set(componentTypeId<Ts>()), ...);
+            return *this;
+        }
+
+        template<typename... Ts>
+        ComponentAccess &write() {
+            (writes.set(componentTypeId<Ts>()), ...);
+            return *this;
+        }
+
+        bool conflictsWith(const ComponentAccess &other) const {
+            return (writes & (other.reads | other.writes)).any() || (other.writes & reads).any();
+        }
+    };
+}
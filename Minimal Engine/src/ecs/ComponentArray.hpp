@@ -1,66 +1,206 @@
 #pragma once
 
-#include <array>
+#include <algorithm>
 #include <cassert>
-#include <unordered_map>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
 
 #include "EntityManager.hpp"
+#include "SparseSet.hpp"
+#include "TagComponent.hpp"
 
 namespace Minimal {
+    // Target size of a single component page in bytes
+    constexpr std::size_t COMPONENT_PAGE_BYTES = 16 * 1024;
+    // Pages start on a cache line so vectorized loops over a page can use aligned loads
+    constexpr std::size_t COMPONENT_PAGE_ALIGNMENT = 64;
+
+    // Largest power of two number of components that fits in a page, at least one
+    constexpr std::size_t componentPageSize(std::size_t componentSize) {
+        std::size_t count = 1;
+        while (count * 2 * componentSize <= COMPONENT_PAGE_BYTES) {
+            count *= 2;
+        }
+        return count;
+    }
+
+    // Tag components only keep the entity set, no data or version pages are allocated for them.
     template<typename T>
     class ComponentArray {
     public:
+        static constexpr size_t PAGE_SIZE = componentPageSize(sizeof(T));
+        static constexpr bool IS_TAG = isTagComponent<T>;
+
         void insertData(Entity entity, const T &component) {
-            assert(m_entityToIndexMap.find(entity) == m_entityToIndexMap.end()
-                && "Component added to same entity more than once.");
-
-            size_t newIndex = m_size;
-            m_entityToIndexMap[entity] = newIndex;
-            m_indexToEntityMap[newIndex] = entity;
-            m_componentArray[newIndex] = component;
-            ++m_size;
+            assert(!m_entities.contains(entity) && "Component added to same entity more than once.");
+
+            size_t newIndex = m_entities.insert(entity);
+            if constexpr (!IS_TAG) {
+                if (newIndex / PAGE_SIZE == m_pages.size())
+                    addPage();
+
+                dataAt(newIndex) = component;
+                versionAt(newIndex) = 0;
+            }
         }
 
-        void removeData(Entity entity) {
-            assert(m_entityToIndexMap.find(entity) != m_entityToIndexMap.end()
-                && "Removing non-existent component.");
+        // Appends count components in one pass, allocating every page needed up front and copying page by page.
+        void insertData(const Entity *entities, const T *components, size_t count) {
+            const size_t first = m_entities.size();
+            m_entities.reserve(first + count);
+            for (size_t i = 0; i < count; ++i) {
+                assert(!m_entities.contains(entities[i]) && "Component added to same entity more than once.");
+                m_entities.insert(entities[i]);
+            }
+            if constexpr (IS_TAG)
+                return;
 
-            size_t indexOfRemoved = m_entityToIndexMap[entity];
-            size_t indexOfLast = m_size - 1;
-            m_componentArray[indexOfRemoved] = m_componentArray[indexOfLast];
+            const size_t pagesNeeded = (first + count + PAGE_SIZE - 1) / PAGE_SIZE;
+            while (m_pages.size() < pagesNeeded) {
+                addPage();
+            }
 
-            Entity entityOfLast = m_indexToEntityMap[indexOfLast];
-            m_entityToIndexMap[entityOfLast] = indexOfRemoved;
-            m_indexToEntityMap[indexOfRemoved] = entityOfLast;
+            size_t copied = 0;
+            while (copied < count) {
+                const size_t index = first + copied;
+                const size_t run = std::min(count - copied, PAGE_SIZE - index % PAGE_SIZE);
+                std::copy_n(components + copied, run, &dataAt(index));
+                std::fill_n(&versionAt(index), run, 0u);
+                copied += run;
+            }
+        }
+
+        // Appends a copy of component for each of count entities, filling page by page and stamping the copies
+        // with the given change version.
+        void insertCopies(const Entity *entities, const T &component, size_t count, std::uint32_t version) {
+            const size_t first = m_entities.size();
+            m_entities.reserve(first + count);
+            for (size_t i = 0; i < count; ++i) {
+                assert(!m_entities.contains(entities[i]) && "Component added to same entity more than once.");
+                m_entities.insert(entities[i]);
+            }
+            if constexpr (IS_TAG)
+                return;
+
+            const size_t pagesNeeded = (first + count + PAGE_SIZE - 1) / PAGE_SIZE;
+            while (m_pages.size() < pagesNeeded) {
+                addPage();
+            }
 
-            m_entityToIndexMap.erase(entity);
-            m_indexToEntityMap.erase(indexOfLast);
+            size_t copied = 0;
+            while (copied < count) {
+                const size_t index = first + copied;
+                const size_t run = std::min(count - copied, PAGE_SIZE - index % PAGE_SIZE);
+                std::fill_n(&dataAt(index), run, component);
+                std::fill_n(&versionAt(index), run, version);
+                copied += run;
+            }
+        }
 
-            --m_size;
+        void removeData(Entity entity) {
+            removeDense(entity);
+            releaseSparePages();
+        }
+
+        // Removes count components, releasing unused pages once at the end.
+        void removeData(const Entity *entities, size_t count) {
+            for (size_t i = 0; i < count; ++i) {
+                removeDense(entities[i]);
+            }
+            releaseSparePages();
         }
 
         T &getData(Entity entity) {
-            assert(m_entityToIndexMap.find(entity) != m_entityToIndexMap.end()
-                && "Retrieving non-existent component.");
-            return m_componentArray[m_entityToIndexMap[entity]];
+            assert(m_entities.contains(entity) && "Retrieving non-existent component.");
+            return dataAt(m_entities.indexOf(entity));
+        }
+
+        // Mutable access that stamps the component with the given change version.
+        T &writeData(Entity entity, std::uint32_t version) {
+            assert(m_entities.contains(entity) && "Retrieving non-existent component.");
+            size_t index = m_entities.indexOf(entity);
+            if constexpr (!IS_TAG)
+                versionAt(index) = version;
+            return dataAt(index);
+        }
+
+        // Tags are never written, their version stays 0.
+        std::uint32_t getVersion(Entity entity) const {
+            assert(m_entities.contains(entity) && "Retrieving non-existent component.");
+            if constexpr (IS_TAG)
+                return 0;
+            else
+                return versionAt(m_entities.indexOf(entity));
         }
 
         bool hasData(Entity entity) const {
-            return (m_entityToIndexMap.find(entity) != m_entityToIndexMap.end());
+            return m_entities.contains(entity);
         }
 
-        void destroyEntity(Entity entity) {
-            if (hasData(entity)) {
-                removeData(entity);
+        // Dense access in the same order as getEntities(), used to iterate the array linearly
+        T &dataAt(size_t index) {
+            if constexpr (IS_TAG)
+                return tagInstance<T>();
+            else
+                return m_pages[index / PAGE_SIZE]->components[index % PAGE_SIZE];
+        }
+
+        // Change version of the component at a dense index, 0 if it was never written after being added
+        std::uint32_t &versionAt(size_t index) { return m_versionPages[index / PAGE_SIZE][index % PAGE_SIZE]; }
+
+        std::uint32_t versionAt(size_t index) const { return m_versionPages[index / PAGE_SIZE][index % PAGE_SIZE]; }
+
+        // Exchanges the components at two dense indices along with their entities and change versions.
+        void swapDense(size_t a, size_t b) {
+            m_entities.swapIndices(a, b);
+            if constexpr (!IS_TAG) {
+                std::swap(dataAt(a), dataAt(b));
+                std::swap(versionAt(a), versionAt(b));
             }
         }
 
-        size_t size() const { return m_size; }
+        const SparseSet &getEntities() const { return m_entities; }
+
+        size_t size() const { return m_entities.size(); }
 
     private:
-        std::array<T, MAX_ENTITIES> m_componentArray{};
-        std::unordered_map<Entity, size_t> m_entityToIndexMap{};
-        std::unordered_map<size_t, Entity> m_indexToEntityMap{};
-        size_t m_size = 0;
+        // Moves the last component into the removed one's slot
+        void removeDense(Entity entity) {
+            assert(m_entities.contains(entity) && "Removing non-existent component.");
+
+            size_t indexOfRemoved = m_entities.erase(entity);
+            size_t indexOfLast = m_entities.size();
+            if constexpr (!IS_TAG) {
+                if (indexOfRemoved != indexOfLast) {
+                    dataAt(indexOfRemoved) = std::move(dataAt(indexOfLast));
+                    versionAt(indexOfRemoved) = versionAt(indexOfLast);
+                }
+            }
+        }
+
+        // Keep one spare page around so an add/remove pair at a page boundary does not thrash the allocator
+        void releaseSparePages() {
+            size_t pagesInUse = (m_entities.size() + PAGE_SIZE - 1) / PAGE_SIZE;
+            while (m_pages.size() > pagesInUse + 1) {
+                m_pages.pop_back();
+                m_versionPages.pop_back();
+            }
+        }
+
+        void addPage() {
+            m_pages.push_back(std::make_unique<Page>());
+            m_versionPages.push_back(std::make_unique<std::uint32_t[]>(PAGE_SIZE));
+        }
+
+        struct alignas(alignof(T) > COMPONENT_PAGE_ALIGNMENT ? alignof(T) : COMPONENT_PAGE_ALIGNMENT) Page {
+            T components[PAGE_SIZE];
+        };
+
+        std::vector<std::unique_ptr<Page> > m_pages{};
+        std::vector<std::unique_ptr<std::uint32_t[]> > m_versionPages{};
+        SparseSet m_entities{};
     };
 }
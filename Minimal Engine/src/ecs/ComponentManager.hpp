@@ -1,10 +1,12 @@
 #pragma once
 
+#include <array>
 #include <memory>
-#include <unordered_map>
-#include <typeindex>
 #include <cassert>
+#include <vector>
 #include "ComponentArray.hpp"
+#include "ComponentTypeId.hpp"
+#include "StorageOrder.hpp"
 
 namespace Minimal
 {
@@ -13,16 +15,38 @@ namespace Minimal
     public:
         virtual ~IComponentArray() = default;
 
+        // Both expect every entity to hold the component, callers go by the entity's signature
         virtual void destroyEntity(Entity entity) = 0;
+
+        virtual void destroyEntities(const Entity* entities, size_t count) = 0;
+
+        virtual const SparseSet& getEntities() const = 0;
+
+        virtual void swapDense(size_t a, size_t b) = 0;
     };
 
     template <typename T>
-    class ConcreteComponentArray : public IComponentArray, public ComponentArray<T>
+    class ConcreteComponentArray final : public IComponentArray, public ComponentArray<T>
     {
     public:
         void destroyEntity(Entity entity) override
         {
-            this->destroyEntity(entity);
+            ComponentArray<T>::removeData(entity);
+        }
+
+        void destroyEntities(const Entity* entities, size_t count) override
+        {
+            ComponentArray<T>::removeData(entities, count);
+        }
+
+        const SparseSet& getEntities() const override
+        {
+            return ComponentArray<T>::getEntities();
+        }
+
+        void swapDense(size_t a, size_t b) override
+        {
+            ComponentArray<T>::swapDense(a, b);
         }
     };
 
@@ -32,57 +56,146 @@ namespace Minimal
         template <typename T>
         void registerComponent()
         {
-            std::type_index typeName = typeid(T);
+            ComponentType type = componentTypeId<T>();
 
-            assert(m_componentArrays.find(typeName) == m_componentArrays.end()
-                && "Registering component type more than once.");
+            assert(m_componentArrays[type] == nullptr && "Registering component type more than once.");
 
-            m_componentArrays[typeName] = std::make_shared<ConcreteComponentArray<T>>();
+            m_componentArrays[type] = std::make_unique<ConcreteComponentArray<T>>();
+        }
+
+        template <typename T>
+        ComponentType getComponentType() const
+        {
+            ComponentType type = componentTypeId<T>();
+            assert(m_componentArrays[type] != nullptr && "Component not registered before use.");
+            return type;
         }
 
         template <typename T>
         void addComponent(Entity entity, const T& component)
         {
-            getComponentArray<T>()->insertData(entity, component);
+            getComponentArray<T>().insertData(entity, component);
+        }
+
+        template <typename T>
+        void addComponents(const Entity* entities, const T* components, size_t count)
+        {
+            getComponentArray<T>().insertData(entities, components, count);
+        }
+
+        template <typename T>
+        void addComponentCopies(const Entity* entities, const T& component, size_t count, std::uint32_t version)
+        {
+            getComponentArray<T>().insertCopies(entities, component, count, version);
         }
 
         template <typename T>
         void removeComponent(Entity entity)
         {
-            getComponentArray<T>()->removeData(entity);
+            getComponentArray<T>().removeData(entity);
         }
 
         template <typename T>
         T& getComponent(Entity entity)
         {
-            return getComponentArray<T>()->getData(entity);
+            return getComponentArray<T>().getData(entity);
+        }
+
+        template <typename T>
+        T& writeComponent(Entity entity, std::uint32_t version)
+        {
+            return getComponentArray<T>().writeData(entity, version);
+        }
+
+        template <typename T>
+        std::uint32_t getChangeVersion(Entity entity)
+        {
+            return getComponentArray<T>().getVersion(entity);
         }
 
         template <typename T>
         bool hasComponent(Entity entity)
         {
-            return getComponentArray<T>()->hasData(entity);
+            return getComponentArray<T>().hasData(entity);
         }
 
-        void destroyEntity(Entity entity)
+        // Removes the entity's components, touching only the arrays named in its signature.
+        void destroyEntity(Entity entity, const Signature& signature)
         {
-            for (auto const& pair : m_componentArrays)
+            for (ComponentType type = 0; type < MAX_COMPONENTS; ++type)
             {
-                auto const& componentArray = pair.second;
-                componentArray->destroyEntity(entity);
+                if (signature.test(type))
+                    m_componentArrays[type]->destroyEntity(entity);
             }
         }
 
-    private:
-        std::unordered_map<std::type_index, std::shared_ptr<IComponentArray>> m_componentArrays{};
+        // Batch variant of destroyEntity. Entities are bucketed by component type first,
+        // so every array is visited once for the whole batch.
+        void destroyEntities(const Entity* entities, const Signature* signatures, size_t count)
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                for (ComponentType type = 0; type < MAX_COMPONENTS; ++type)
+                {
+                    if (signatures[i].test(type))
+                        m_destroyBuckets[type].push_back(entities[i]);
+                }
+            }
+
+            for (ComponentType type = 0; type < MAX_COMPONENTS; ++type)
+            {
+                std::vector<Entity>& bucket = m_destroyBuckets[type];
+                if (bucket.empty())
+                    continue;
+
+                m_componentArrays[type]->destroyEntities(bucket.data(), bucket.size());
+                bucket.clear();
+            }
+        }
+
+        // Moves every array a step closer to ascending keyOf(entity) order, comparing at most budget pairs of
+        // entries in total. Arrays are visited round-robin, each one until it is sorted or the budget runs out,
+        // so repeated calls keep working through all of them. Returns the number of comparisons made.
+        template <typename KeyOf>
+        size_t sortStorage(size_t budget, KeyOf&& keyOf)
+        {
+            size_t steps = 0;
+            for (size_t visited = 0; visited < MAX_COMPONENTS && steps < budget; ++visited)
+            {
+                IComponentArray* array = m_componentArrays[m_sortCursor].get();
+                if (array != nullptr)
+                {
+                    const SparseSet& entities = array->getEntities();
+                    const size_t remaining = budget - steps;
+                    const size_t taken = m_sorters[m_sortCursor].run(
+                        entities.size(), remaining,
+                        [&](size_t index) { return keyOf(entities.entityAt(index)); },
+                        [&](size_t a, size_t b) { array->swapDense(a, b); });
+                    steps += taken;
+                    // Out of budget midway, carry on with the same array next time
+                    if (taken == remaining)
+                        break;
+                }
+                m_sortCursor = (m_sortCursor + 1) % MAX_COMPONENTS;
+            }
+            return steps;
+        }
 
         template <typename T>
-        std::shared_ptr<ConcreteComponentArray<T>> getComponentArray()
+        ConcreteComponentArray<T>& getComponentArray()
         {
-            std::type_index typeName = typeid(T);
-            assert(m_componentArrays.find(typeName) != m_componentArrays.end()
-                && "Component not registered before use.");
-            return std::static_pointer_cast<ConcreteComponentArray<T>>(m_componentArrays[typeName]);
+            ComponentType type = componentTypeId<T>();
+            assert(m_componentArrays[type] != nullptr && "Component not registered before use.");
+            return *static_cast<ConcreteComponentArray<T>*>(m_componentArrays[type].get());
         }
+
+    private:
+        // Indexed by component type ID, null for types that were not registered with this manager
+        std::array<std::unique_ptr<IComponentArray>, MAX_COMPONENTS> m_componentArrays{};
+        // Scratch space of destroyEntities, kept to reuse its capacity
+        std::array<std::vector<Entity>, MAX_COMPONENTS> m_destroyBuckets{};
+        // Progress of sortStorage, per array and across arrays
+        std::array<IncrementalSorter, MAX_COMPONENTS> m_sorters{};
+        ComponentType m_sortCursor = 0;
     };
 }
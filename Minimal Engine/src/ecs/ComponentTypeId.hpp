@@ -0,0 +1,37 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+
+#include "EntityManager.hpp"
+
+namespace Minimal {
+    namespace detail {
+        inline std::size_t nextComponentTypeId() {
+            static std::atomic<std::size_t> counter{0};
+            return counter.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // Dense ID of a component type, assigned once on first use and shared by every coordinator.
+    // Used directly as the signature bit and as the index into per-type storage tables.
+    // cv-qualified types share the ID of the unqualified type, so const T can be used to request read-only access.
+    // Throws once more than MAX_COMPONENTS types are in use, in every build, as the ID would index past the tables.
+    template<typename T>
+    ComponentType componentTypeId() {
+        if constexpr (!std::is_same_v<T, std::remove_cv_t<T> >) {
+            return componentTypeId<std::remove_cv_t<T> >();
+        }
+        else {
+            static const ComponentType id = [] {
+                std::size_t next = detail::nextComponentTypeId();
+                if (next >= MAX_COMPONENTS)
+                    throw std::runtime_error("Too many component types in use, raise MAX_COMPONENTS.");
+                return static_cast<ComponentType>(next);
+            }();
+            return id;
+        }
+    }
+}
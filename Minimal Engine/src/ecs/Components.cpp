@@ -13,7 +13,7 @@ namespace Minimal {
         rotation = quaternion * rotation;
     }
 
-    glm::mat4 TransformComponent::mat4() {
+    glm::mat4 TransformComponent::mat4() const {
         glm::mat4 translation = translate(glm::mat4(1.0f), position);
         glm::mat4 rotationZ = glm::rotate(glm::mat4(1.0f), glm::roll(rotation), glm::vec3(0, 0, 1));
         glm::mat4 rotationX = glm::rotate(glm::mat4(1.0f), glm::pitch(rotation), glm::vec3(1, 0, 0));
@@ -26,7 +26,7 @@ namespace Minimal {
         return translation * rotationMat * scaling;
     }
 
-    glm::mat3 TransformComponent::normalMatrix() {
+    glm::mat3 TransformComponent::normalMatrix() const {
         const float c3 = glm::cos(glm::roll(rotation));
         const float s3 = glm::sin(glm::roll(rotation));
         const float c2 = glm::cos(glm::pitch(rotation));
@@ -67,4 +67,8 @@ namespace Minimal {
                std::to_string(glm::pitch(rotation)) + ", " + std::to_string(glm::yaw(rotation)) + ", " + std::to_string(glm::roll(rotation)) + "\n" +
                std::to_string(scale.x) + ", " + std::to_string(scale.y) + ", " + std::to_string(scale.z);
     }
+
+    glm::mat3 WorldTransformComponent::normalMatrix() const {
+        return glm::transpose(glm::inverse(glm::mat3(matrix)));
+    }
 }
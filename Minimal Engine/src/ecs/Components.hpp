@@ -1,5 +1,6 @@
 #pragma once
 
+#include "EntityManager.hpp"
 #include "Mesh.hpp"
 
 #include <glm/gtc/quaternion.hpp>
@@ -15,9 +16,9 @@ namespace Minimal {
         // Matrix corrsponds to Translate * Ry * Rx * Rz * Scale
         // Rotations correspond to Tait-bryan angles of Y(1), X(2), Z(3)
         // https://en.wikipedia.org/wiki/Euler_angles#Rotation_matrix // Brendan Galea
-        glm::mat4 mat4();
+        glm::mat4 mat4() const;
 
-        glm::mat3 normalMatrix();
+        glm::mat3 normalMatrix() const;
         glm::vec3 right() const;
         glm::vec3 up() const;
         glm::vec3 forward() const;
@@ -25,6 +26,19 @@ namespace Minimal {
         std::string toString();
     };
 
+    // Places the entity below a parent, its TransformComponent is then relative to the parent's world transform.
+    // Roots of a hierarchy have no parent. Entities whose parent is dead or not part of a hierarchy act as roots.
+    struct HierarchyComponent {
+        Entity parent = INVALID_ENTITY;
+    };
+
+    // World transform of a hierarchy node, computed by TransformSystem from the local transforms above it.
+    struct WorldTransformComponent {
+        glm::mat4 matrix{1.0f};
+
+        glm::mat3 normalMatrix() const;
+    };
+
     struct PointLightComponent {
         float lightIntensity = 1.0f;
         glm::vec3 color{};
@@ -35,7 +49,18 @@ namespace Minimal {
         // will have a material here at a later point.
     };
 
+    // Motion state touched by every integration step. Kept apart from RigidbodyPropertiesComponent so the
+    // integrator streams only these columns.
     struct RigidbodyComponent {
+        glm::vec3 velocity{0, 0, 0};
+        glm::vec3 angularVelocity{0, 0, 0};
+
+        glm::vec3 netForce{0, 0, 0};
+        glm::vec3 netTorque{0, 0, 0};
+    };
+
+    // Rarely changing configuration of a rigidbody, read when forces are applied and collisions resolved.
+    struct RigidbodyPropertiesComponent {
         bool isStatic;
 
         float mass = 1;
@@ -44,12 +69,6 @@ namespace Minimal {
         float dynamicFriction = 0.3f;
 
         glm::vec3 gravity;
-
-        glm::vec3 velocity;
-        glm::vec3 angularVelocity;
-
-        glm::vec3 netForce{0, 0, 0};
-        glm::vec3 netTorque{0, 0, 0};
     };
 
     struct RenderComponent {
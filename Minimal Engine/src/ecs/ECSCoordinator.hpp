@@ -1,86 +1,607 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
 #include <memory>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
 #include "EntityManager.hpp"
+#include "ArchetypeManager.hpp"
+#include "ComponentAccess.hpp"
 #include "ComponentManager.hpp"
 #include "Components.hpp"
+#include "Prefab.hpp"
+#include "StorageMode.hpp"
+#include "StorageOrder.hpp"
+#include "SystemManager.hpp"
+#include "TagComponent.hpp"
+#include "View.hpp"
+#include "scheduler/Fiber.h"
+#include "scheduler/RWSpinLock.h"
+#include "scheduler/Scheduler.h"
 #include "scheduler/SpinLock.h"
 
 namespace Minimal {
+    class EntityCommandBuffer;
+
+    // Concurrency model: tasks that touch components declare a ComponentAccess and run inside withAccess().
+    // Declared reads take a shared lock on the component type and writes an exclusive one, so tasks over disjoint
+    // or read-only data run in parallel. Structural changes (creating and destroying entities, adding and removing
+    // components, registering types and systems) are exclusive with every task that holds an access set.
+    //
+    // Debug builds check every component access against the access set of the task making it: reads need the
+    // type declared as read or written, mutable access (getComponent<T>, views over non-const T) needs it
+    // declared as written. While no task holds an access set, e.g. during setup, everything is allowed.
     class ECSCoordinator {
+        friend class EntityCommandBuffer;
+
     public:
-        ECSCoordinator() {
-            m_entityManager = std::make_unique<EntityManager>();
-            m_componentManager = std::make_unique<ComponentManager>();
+        // maxEntities bounds the number of living entities; component storage grows in pages up to that bound.
+        // Creating entities past it fails without side effects, see createEntity() and createEntities().
+        explicit ECSCoordinator(StorageMode storageMode = StorageMode::ComponentArray,
+                                std::uint32_t maxEntities = DEFAULT_MAX_ENTITIES)
+            : m_storageMode(storageMode) {
+            m_entityManager = std::make_unique<EntityManager>(maxEntities);
+            m_systemManager = std::make_unique<SystemManager>();
+            if (m_storageMode == StorageMode::Archetype)
+                m_archetypeManager = std::make_unique<ArchetypeManager>();
+            else
+                m_componentManager = std::make_unique<ComponentManager>();
         }
 
+        // Returns INVALID_ENTITY when maxEntities entities are already alive.
         Entity createEntity() {
-            m_createEntityLock.Acquire();
-            Entity entity = m_entityManager->createEntity();
-            addComponent<TransformComponent>(entity, {});
-
-            m_createEntityLock.Release();
+            m_structureLock.AcquireWrite();
+            Entity entity = createEntityUnlocked();
+            m_structureLock.ReleaseWrite();
             return entity;
         }
 
+        // Creates count entities with a default TransformComponent under a single lock and writes them to out.
+        // Returns how many were created, fewer than count if that would exceed maxEntities; the entities that
+        // could not be created are left as INVALID_ENTITY at the end of out.
+        std::size_t createEntities(std::size_t count, Entity *out) {
+            m_structureLock.AcquireWrite();
+            count = m_entityManager->createEntities(count, out);
+            std::vector<TransformComponent> transforms(count);
+            addComponentsUnlocked<TransformComponent>(out, transforms.data(), count);
+            m_structureLock.ReleaseWrite();
+            return count;
+        }
+
+        // Creates count instances of the prefab under a single lock and writes them to out. Every component type
+        // is copied into storage as one block; with archetype storage the instances take consecutive rows.
+        // Returns how many instances were created, like createEntities().
+        std::size_t instantiate(const Prefab &prefab, std::size_t count, Entity *out) {
+            m_structureLock.AcquireWrite();
+            count = instantiateUnlocked(prefab, count, out);
+            m_structureLock.ReleaseWrite();
+            return count;
+        }
+
+        // Like instantiate(), then calls patch(i, components...) with the Ts of the i-th instance, so per-instance
+        // values such as positions are in place before the lock is released.
+        template<typename... Ts, typename Func>
+        std::size_t instantiate(const Prefab &prefab, std::size_t count, Entity *out, Func &&patch) {
+            assert((prefab.has<Ts>() && ...) && "Patched component is not part of the prefab.");
+
+            m_structureLock.AcquireWrite();
+            count = instantiateUnlocked(prefab, count, out);
+            for (std::size_t i = 0; i < count; ++i) {
+                patch(i, storedComponent<Ts>(out[i])...);
+            }
+            m_structureLock.ReleaseWrite();
+            return count;
+        }
+
+        // Destroying a stale handle is a no-op, so systems holding on to old handles cannot hit a recycled entity.
         void destroyEntity(Entity entity) {
-            m_destroyEntityLock.Acquire();
-            m_entityManager->destroyEntity(entity);
-            m_componentManager->destroyEntity(entity);
-            m_destroyEntityLock.Release();
+            m_structureLock.AcquireWrite();
+            destroyEntityUnlocked(entity);
+            m_structureLock.ReleaseWrite();
+        }
+
+        // Destroys count entities under a single lock, removing their components one component type at a time.
+        // Stale handles and repeated entities are skipped.
+        void destroyEntities(const Entity *entities, std::size_t count) {
+            m_structureLock.AcquireWrite();
+            destroyEntitiesUnlocked(entities, count);
+            m_structureLock.ReleaseWrite();
         }
 
         int getEntityCount() const {
             return m_entityManager->getEntityCount();
         }
 
+        // False for handles whose entity has been destroyed, even if its slot was reused since.
+        bool isAlive(Entity entity) const {
+            return m_entityManager->isAlive(entity);
+        }
+
+        StorageMode getStorageMode() const {
+            return m_storageMode;
+        }
+
         template<typename T>
         void registerComponent() {
-            m_registerComponentLock.Acquire();
-            m_componentManager->registerComponent<T>();
-            m_registerComponentLock.Release();
+            m_structureLock.AcquireWrite();
+            if (m_storageMode == StorageMode::Archetype)
+                m_archetypeManager->registerComponent<T>();
+            else
+                m_componentManager->registerComponent<T>();
+            m_structureLock.ReleaseWrite();
         }
 
         template<typename T>
         void addComponent(Entity entity, const T &component) {
-            m_addComponentLock.Acquire();
-            m_componentManager->addComponent<T>(entity, component);
-            m_addComponentLock.Release();
+            m_structureLock.AcquireWrite();
+            addComponentUnlocked<T>(entity, component);
+            m_structureLock.ReleaseWrite();
+        }
+
+        // Adds components[i] to entities[i] for every i under a single lock, appending to storage in one pass.
+        template<typename T>
+        void addComponents(const Entity *entities, const T *components, std::size_t count) {
+            m_structureLock.AcquireWrite();
+            addComponentsUnlocked<T>(entities, components, count);
+            m_structureLock.ReleaseWrite();
         }
 
         template<typename T>
         void removeComponent(Entity entity) {
-            m_removeComponentLock.Acquire();
-            m_componentManager->removeComponent<T>(entity);
-            m_removeComponentLock.Release();
+            m_structureLock.AcquireWrite();
+            removeComponentUnlocked<T>(entity);
+            m_structureLock.ReleaseWrite();
         }
 
+        // getComponent<T> stamps the component as changed at the current change version,
+        // getComponent<const T> is a read-only fetch that leaves it untouched.
         template<typename T>
         T &getComponent(Entity entity) {
-            m_getComponentLock.Acquire();
-            T& component = m_componentManager->getComponent<T>(entity);
-            m_getComponentLock.Release();
-            return component;
+            using Component = std::remove_const_t<T>;
+            static_assert(!isTagComponent<T>, "Tag components have no data, use hasComponent instead.");
+            assert(m_entityManager->isAlive(entity) && "Retrieving component of a dead entity.");
+            assert(isAccessDeclared<T>() && "Component accessed without being declared in the task's access set.");
+
+            if constexpr (std::is_const_v<T>)
+                return m_storageMode == StorageMode::Archetype
+                           ? m_archetypeManager->getComponent<Component>(entity)
+                           : m_componentManager->getComponent<Component>(entity);
+            else
+                return m_storageMode == StorageMode::Archetype
+                           ? m_archetypeManager->writeComponent<Component>(entity, getChangeVersion())
+                           : m_componentManager->writeComponent<Component>(entity, getChangeVersion());
         }
 
+        // Tests the component's bit in the entity's signature, without touching component storage.
         template<typename T>
         bool hasComponent(Entity entity) {
-            m_hasComponentLock.Acquire();
-            bool result = m_componentManager->hasComponent<T>(entity);
-            m_hasComponentLock.Release();
-            return result;
+            return m_entityManager->isAlive(entity)
+                   && m_entityManager->getSignature(entity).test(getComponentType<std::remove_const_t<T> >());
         }
 
+        // Stamps the component as changed without fetching it, for writes made through a reference held earlier.
+        template<typename T>
+        void markDirty(Entity entity) {
+            static_assert(!std::is_const_v<T>, "markDirty<const T> would not stamp the component.");
+            getComponent<T>(entity);
+        }
+
+        // Calls func(component) and stamps the component as changed.
+        template<typename T, typename Func>
+        void patch(Entity entity, Func &&func) {
+            static_assert(!std::is_const_v<T>, "patch<const T> would not stamp the component.");
+            func(getComponent<T>(entity));
+        }
+
+        // True if the component was added or written after the given change version. With archetype storage
+        // changes are tracked per chunk, so this can also report writes to other entities in the same chunk.
+        template<typename T>
+        bool hasChangedSince(Entity entity, std::uint32_t version) {
+            using Component = std::remove_const_t<T>;
+            static_assert(!isTagComponent<T>, "Tag components are not change tracked.");
+            const std::uint32_t changed = m_storageMode == StorageMode::Archetype
+                                              ? m_archetypeManager->getChangeVersion(
+                                                  entity, m_archetypeManager->getComponentType<Component>())
+                                              : m_componentManager->getChangeVersion<Component>(entity);
+            return changed > version;
+        }
+
+        // Version stamped onto components written from now on. Starts at 1, so 0 means "never seen".
+        std::uint32_t getChangeVersion() const {
+            return m_changeVersion.load(std::memory_order_relaxed);
+        }
+
+        // Starts a new change version and returns the previous one. A consumer that stores the returned value
+        // and later queries changedSince(stored) sees every write made after this call, including writes
+        // made while it was still processing the previous batch of changes. Every consumer advances on its own
+        // and several doing so in one frame is intended, other advances only split the versions finer.
+        std::uint32_t advanceChangeVersion() {
+            return m_changeVersion.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        template<typename T>
+        ComponentType getComponentType() const {
+            return m_storageMode == StorageMode::Archetype
+                       ? m_archetypeManager->getComponentType<T>()
+                       : m_componentManager->getComponentType<T>();
+        }
+
+        // Signature with the bits of every component type in Ts set.
+        template<typename... Ts>
+        Signature makeSignature() const {
+            Signature signature{};
+            (signature.set(getComponentType<Ts>()), ...);
+            return signature;
+        }
+
+        const Signature &getSignature(Entity entity) const {
+            return m_entityManager->getSignature(entity);
+        }
+
+        // Registers the cache of a Query. With archetype storage the matching archetypes are tracked, otherwise
+        // the matching entities; only the one in use is filled. Structural changes patch it from then on, entities
+        // that already match are added immediately.
+        void registerQuery(const Signature &signature, SparseSet &entities, std::vector<Archetype *> &archetypes) {
+            m_structureLock.AcquireWrite();
+            if (m_storageMode == StorageMode::Archetype) {
+                m_archetypeManager->registerQuery(archetypes, signature);
+                m_structureLock.ReleaseWrite();
+                return;
+            }
+
+            m_systemManager->registerSystem(entities, signature);
+            const std::uint32_t allocatedEntities = m_entityManager->getAllocatedEntityCount();
+            for (std::uint32_t index = 0; index < allocatedEntities; ++index) {
+                Entity entity = m_entityManager->entityAt(index);
+                if (m_entityManager->isAlive(entity)
+                    && (m_entityManager->getSignature(entity) & signature) == signature)
+                    entities.insert(entity);
+            }
+            m_structureLock.ReleaseWrite();
+        }
+
+        void unregisterQuery(SparseSet &entities, std::vector<Archetype *> &archetypes) {
+            m_structureLock.AcquireWrite();
+            if (m_storageMode == StorageMode::Archetype)
+                m_archetypeManager->unregisterQuery(archetypes);
+            else
+                m_systemManager->unregisterSystem(entities);
+            m_structureLock.ReleaseWrite();
+        }
+
+        // Blocks until the access set can be granted. Component locks are taken in type order so tasks with
+        // overlapping sets cannot deadlock. Structural changes must not be made while an access set is held.
+        void acquireAccess(const ComponentAccess &access) {
+            m_structureLock.AcquireRead();
+            for (ComponentType type = 0; type < MAX_COMPONENTS; ++type) {
+                if (access.writes.test(type))
+                    m_componentLocks[type].lock.AcquireWrite();
+                else if (access.reads.test(type))
+                    m_componentLocks[type].lock.AcquireRead();
+            }
+#ifndef NDEBUG
+            m_declaredAccessLock.Acquire();
+            const bool nested = !m_declaredAccess.emplace(accessOwner(), access).second;
+            m_declaredAccessLock.Release();
+            assert(!nested && "Access sets cannot be nested.");
+#endif
+        }
+
+        // Called by the same task that acquired the access set, which may have moved to another thread since.
+        void releaseAccess(const ComponentAccess &access) {
+#ifndef NDEBUG
+            m_declaredAccessLock.Acquire();
+            m_declaredAccess.erase(accessOwner());
+            m_declaredAccessLock.Release();
+#endif
+            for (ComponentType type = 0; type < MAX_COMPONENTS; ++type) {
+                if (access.writes.test(type))
+                    m_componentLocks[type].lock.ReleaseWrite();
+                else if (access.reads.test(type))
+                    m_componentLocks[type].lock.ReleaseRead();
+            }
+            m_structureLock.ReleaseRead();
+        }
+
+        // Runs func while holding the access set.
+        template<typename Func>
+        void withAccess(const ComponentAccess &access, Func &&func) {
+            acquireAccess(access);
+            func();
+            releaseAccess(access);
+        }
+
+        // Lightweight query over every entity that has all of Ts. Supports range-for with
+        // structured bindings (auto [entity, a, b]) as well as each(func).
+        template<typename... Ts>
+        View<Ts...> view() {
+            assert((... && isAccessDeclared<Ts>()) && "Component accessed without being declared in the task's access set.");
+            if (m_storageMode == StorageMode::Archetype)
+                return View<Ts...>(getChangeVersion(),
+                                   std::make_shared<const std::vector<Archetype *> >(
+                                       m_archetypeManager->getMatchingArchetypes<Ts...>()),
+                                   {m_archetypeManager->getComponentType<Ts>()...});
+
+            return View<Ts...>(getChangeVersion(),
+                               m_componentManager->getComponentArray<std::remove_const_t<Ts> >()...);
+        }
+
+        // View driven by an entity set that is known to match Ts, such as a registered system's entities.
+        // Iteration cost scales with the size of the set rather than with the component pools.
+        template<typename... Ts>
+        View<Ts...> view(const SparseSet &entities) {
+            assert((... && isAccessDeclared<Ts>()) && "Component accessed without being declared in the task's access set.");
+            if (m_storageMode == StorageMode::Archetype)
+                return View<Ts...>(getChangeVersion(), entities, *m_archetypeManager,
+                                   {m_archetypeManager->getComponentType<Ts>()...});
+
+            return View<Ts...>(getChangeVersion(), entities,
+                               m_componentManager->getComponentArray<std::remove_const_t<Ts> >()...);
+        }
+
+        // View streaming the chunks of archetypes known to match Ts, such as the cached list of a Query.
+        // Only available with archetype storage.
+        template<typename... Ts>
+        View<Ts...> view(std::shared_ptr<const std::vector<Archetype *> > archetypes) {
+            assert(m_storageMode == StorageMode::Archetype && "Archetype lists require archetype storage.");
+            assert((... && isAccessDeclared<Ts>()) && "Component accessed without being declared in the task's access set.");
+            return View<Ts...>(getChangeVersion(), std::move(archetypes),
+                               {m_archetypeManager->getComponentType<Ts>()...});
+        }
+
+        // Calls func for every entity that has all of Ts, either as func(entity, components...) or func(components...).
+        template<typename... Ts, typename Func>
+        void each(Func &&func) {
+            view<Ts...>().each(std::forward<Func>(func));
+        }
+
+        // Like each(), but splits the matching entities into ranges of about grainSize entities and runs one
+        // scheduler task per range, returning once all of them are done. Must be called from a scheduler task.
+        // func runs concurrently on several threads: it may only touch the components it is handed, and
+        // structural changes have to go through one EntityCommandBuffer per range.
+        template<typename... Ts, typename Func>
+        void parallelEach(Func &&func, std::size_t grainSize = DEFAULT_GRAIN_SIZE) {
+            parallelEach(view<Ts...>(), std::forward<Func>(func), grainSize);
+        }
+
+        // parallelEach() over an existing view, e.g. one of a Query or one filtered by changedSince().
+        template<typename... Ts, typename Func>
+        void parallelEach(const View<Ts...> &query, Func &&func, std::size_t grainSize = DEFAULT_GRAIN_SIZE) {
+            const std::vector<typename View<Ts...>::Range> ranges = query.split(grainSize);
+            if (ranges.size() <= 1) {
+                query.each(std::forward<Func>(func));
+                return;
+            }
+
+            Counter *counter = Scheduler::CreateCounter();
+            for (const typename View<Ts...>::Range &range : ranges) {
+                Scheduler::QueueTask([&query, &func, range]() { query.each(range, func); },
+                                     TaskPriority::HIGH, counter);
+            }
+            Scheduler::WaitForCounter(counter);
+            Scheduler::DestroyCounter(counter);
+        }
+
+        // Entities per parallelEach() task unless the caller asks otherwise
+        static constexpr std::size_t DEFAULT_GRAIN_SIZE = 1024;
+
+        // Incremental compaction pass: moves component storage a step closer to the given order, comparing at
+        // most budget pairs of entries, and picks up where the previous call stopped. Calling it
+        // once per frame amortizes a full sort over several frames and then keeps storage sorted as entities
+        // move, are added or are removed. With StorageOrder::Morton, positions are quantized to cells of
+        // cellSize units and entities without a TransformComponent are sorted last. Takes the structure lock,
+        // so it must not run while a task holds an access set. Returns the number of comparisons made.
+        std::size_t sortStorage(StorageOrder order, std::size_t budget, float cellSize = 1.0f) {
+            m_structureLock.AcquireWrite();
+            const ComponentType transformType = getComponentType<TransformComponent>();
+            auto keyOf = [&](Entity entity) -> std::uint64_t {
+                if (order == StorageOrder::EntityIndex)
+                    return entityIndex(entity);
+                if (!m_entityManager->getSignature(entity).test(transformType))
+                    return UINT64_MAX;
+
+                const TransformComponent &transform = m_storageMode == StorageMode::Archetype
+                                                          ? m_archetypeManager->getComponent<TransformComponent>(entity)
+                                                          : m_componentManager->getComponent<TransformComponent>(entity);
+                return mortonCode(transform.position.x, transform.position.y, transform.position.z, cellSize);
+            };
+
+            const std::size_t steps = m_storageMode == StorageMode::Archetype
+                                          ? m_archetypeManager->sortStorage(budget, keyOf)
+                                          : m_componentManager->sortStorage(budget, keyOf);
+            m_structureLock.ReleaseWrite();
+            return steps;
+        }
 
     private:
+        // Structural changes without taking the structure lock, for callers that already hold it exclusively.
+        Entity createEntityUnlocked() {
+            Entity entity = m_entityManager->createEntity();
+            if (entity != INVALID_ENTITY)
+                addComponentUnlocked<TransformComponent>(entity, {});
+            return entity;
+        }
+
+        std::size_t instantiateUnlocked(const Prefab &prefab, std::size_t count, Entity *out) {
+            count = m_entityManager->createEntities(count, out);
+            if (count == 0)
+                return 0;
+
+            const Signature &signature = prefab.getSignature();
+            if (m_storageMode == StorageMode::Archetype) {
+                std::array<const void *, MAX_COMPONENTS> values{};
+                for (const Prefab::ComponentDefault &component : prefab.m_components) {
+                    values[component.type] = component.value.get();
+                }
+                m_archetypeManager->instantiate(signature, values.data(), out, count, getChangeVersion());
+            } else {
+                for (const Prefab::ComponentDefault &component : prefab.m_components) {
+                    component.addToArray(*m_componentManager, out, count, component.value.get(), getChangeVersion());
+                }
+            }
+
+            for (std::size_t i = 0; i < count; ++i) {
+                m_entityManager->setSignature(out[i], signature);
+                m_systemManager->entityCreated(out[i], signature);
+            }
+            return count;
+        }
+
+        // Component as held by storage, without stamping it. Instances are patched while they are still
+        // marked as added, so the write needs no version of its own.
+        template<typename T>
+        std::remove_const_t<T> &storedComponent(Entity entity) {
+            using Component = std::remove_const_t<T>;
+            static_assert(!isTagComponent<T>, "Tag components have no data, use hasComponent instead.");
+            return m_storageMode == StorageMode::Archetype
+                       ? m_archetypeManager->getComponent<Component>(entity)
+                       : m_componentManager->getComponent<Component>(entity);
+        }
+
+        void destroyEntityUnlocked(Entity entity) {
+            if (!m_entityManager->isAlive(entity))
+                return;
+
+            // Copied, destroying the entity clears its signature
+            const Signature signature = m_entityManager->getSignature(entity);
+            m_systemManager->entityDestroyed(entity, signature);
+            m_entityManager->destroyEntity(entity);
+            if (m_storageMode == StorageMode::Archetype)
+                m_archetypeManager->destroyEntity(entity);
+            else
+                m_componentManager->destroyEntity(entity, signature);
+        }
+
+        void destroyEntitiesUnlocked(const Entity *entities, std::size_t count) {
+            if (m_storageMode == StorageMode::Archetype) {
+                for (std::size_t i = 0; i < count; ++i) {
+                    destroyEntityUnlocked(entities[i]);
+                }
+                return;
+            }
+
+            // Component arrays still hold the old handles, so they can be emptied after the slots are recycled.
+            // A repeated entity is no longer alive the second time around and is skipped.
+            std::vector<Entity> destroyed;
+            std::vector<Signature> signatures;
+            destroyed.reserve(count);
+            signatures.reserve(count);
+            for (std::size_t i = 0; i < count; ++i) {
+                if (!m_entityManager->isAlive(entities[i]))
+                    continue;
+
+                destroyed.push_back(entities[i]);
+                signatures.push_back(m_entityManager->getSignature(entities[i]));
+                m_systemManager->entityDestroyed(entities[i], signatures.back());
+                m_entityManager->destroyEntity(entities[i]);
+            }
+            m_componentManager->destroyEntities(destroyed.data(), signatures.data(), destroyed.size());
+        }
+
+        template<typename T>
+        void addComponentUnlocked(Entity entity, const T &component) {
+            if (m_storageMode == StorageMode::Archetype)
+                m_archetypeManager->addComponent<T>(entity, component);
+            else
+                m_componentManager->addComponent<T>(entity, component);
+            markAdded<T>(entity);
+
+            const ComponentType type = getComponentType<T>();
+            Signature signature = m_entityManager->getSignature(entity);
+            signature.set(type);
+            m_entityManager->setSignature(entity, signature);
+            m_systemManager->entitySignatureChanged(entity, signature, type);
+        }
+
+        template<typename T>
+        void addComponentsUnlocked(const Entity *entities, const T *components, std::size_t count) {
+            if (m_storageMode == StorageMode::Archetype)
+                m_archetypeManager->addComponents<T>(entities, components, count);
+            else
+                m_componentManager->addComponents<T>(entities, components, count);
+
+            const ComponentType type = getComponentType<T>();
+            for (std::size_t i = 0; i < count; ++i) {
+                markAdded<T>(entities[i]);
+                Signature signature = m_entityManager->getSignature(entities[i]);
+                signature.set(type);
+                m_entityManager->setSignature(entities[i], signature);
+                m_systemManager->entitySignatureChanged(entities[i], signature, type);
+            }
+        }
+
+        // Newly added components count as changed so change-filtered queries pick them up.
+        template<typename T>
+        void markAdded(Entity entity) {
+            if (m_storageMode == StorageMode::Archetype)
+                m_archetypeManager->writeComponent<T>(entity, getChangeVersion());
+            else
+                m_componentManager->writeComponent<T>(entity, getChangeVersion());
+        }
+
+        template<typename T>
+        void removeComponentUnlocked(Entity entity) {
+            if (m_storageMode == StorageMode::Archetype)
+                m_archetypeManager->removeComponent<T>(entity);
+            else
+                m_componentManager->removeComponent<T>(entity);
+
+            const ComponentType type = getComponentType<T>();
+            Signature signature = m_entityManager->getSignature(entity);
+            signature.reset(type);
+            m_entityManager->setSignature(entity, signature);
+            m_systemManager->entitySignatureChanged(entity, signature, type);
+        }
+
+#ifndef NDEBUG
+        // Identifies the running task for the access checks: its fiber, or the thread outside of scheduler tasks.
+        // Fibers move between threads when they wait, so thread-local state would not follow the task.
+        static const void *accessOwner() {
+            static thread_local char threadOwner;
+            const void *fiber = Fiber::GetCurrent();
+            return fiber != nullptr ? fiber : &threadOwner;
+        }
+
+        // Debug check: while any task holds an access set, the calling task must have declared T, as written
+        // unless T is const.
+        template<typename T>
+        bool isAccessDeclared() const {
+            if (m_structureLock.GetReaderCount() == 0)
+                return true;
+
+            const ComponentType type = componentTypeId<std::remove_const_t<T> >();
+            m_declaredAccessLock.Acquire();
+            auto it = m_declaredAccess.find(accessOwner());
+            const bool declared = it != m_declaredAccess.end()
+                                  && (it->second.writes.test(type) || (std::is_const_v<T> && it->second.reads.test(type)));
+            m_declaredAccessLock.Release();
+            return declared;
+        }
+#endif
+
+        // Padded to a cache line so tasks locking different component types do not contend
+        struct alignas(64) ComponentLock {
+            RWSpinLock lock;
+        };
+
+        StorageMode m_storageMode;
         std::unique_ptr<EntityManager> m_entityManager;
         std::unique_ptr<ComponentManager> m_componentManager;
-        SpinLock m_createEntityLock;
-        SpinLock m_destroyEntityLock;
-        SpinLock m_getComponentLock;
-        SpinLock m_hasComponentLock;
-        SpinLock m_removeComponentLock;
-        SpinLock m_addComponentLock;
-        SpinLock m_registerComponentLock;
+        std::unique_ptr<ArchetypeManager> m_archetypeManager;
+        std::unique_ptr<SystemManager> m_systemManager;
+        // Held shared by every task inside withAccess(), exclusively by structural changes
+        RWSpinLock m_structureLock;
+        std::array<ComponentLock, MAX_COMPONENTS> m_componentLocks{};
+#ifndef NDEBUG
+        // Access set of every task inside acquireAccess()/releaseAccess(), by accessOwner()
+        std::unordered_map<const void *, ComponentAccess> m_declaredAccess{};
+        mutable SpinLock m_declaredAccessLock;
+#endif
+
+        std::atomic<std::uint32_t> m_changeVersion{1};
     };
 }
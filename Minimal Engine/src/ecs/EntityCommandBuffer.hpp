@@ -0,0 +1,191 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "ComponentTypeId.hpp"
+#include "ECSCoordinator.hpp"
+#include "EntityManager.hpp"
+
+namespace Minimal {
+    // Records structural changes made during a parallel phase and applies them in one batch at a sync point.
+    // A buffer is not thread safe, every thread or task records into its own.
+    //
+    // Entities created through the buffer get a placeholder handle that can be used with later commands of the
+    // same buffer and is resolved to a real entity on playback. Commands that target an entity which is no
+    // longer alive by the time the buffer is played back are skipped. So are commands for created entities that
+    // did not fit under the coordinator's entity limit.
+    //
+    // What an entity holds is only known on playback, so adding a component the entity already has overwrites
+    // it instead (a tag is left as is), and removing one it does not have is skipped.
+    class EntityCommandBuffer {
+    public:
+        Entity createEntity() {
+            Entity placeholder = makeEntity(m_createdCount++, RESERVED_GENERATION);
+            m_commands.push_back({CommandKind::Create, 0, placeholder, 0});
+            return placeholder;
+        }
+
+        void destroyEntity(Entity entity) {
+            m_commands.push_back({CommandKind::Destroy, 0, entity, 0});
+        }
+
+        template<typename T>
+        void addComponent(Entity entity, const T &component) {
+            ComponentType type = componentTypeId<T>();
+            ComponentCommands<T> &payloads = getPayloads<T>();
+            m_commands.push_back({CommandKind::Add, type, entity, payloads.components.size()});
+            payloads.components.push_back(component);
+        }
+
+        template<typename T>
+        void removeComponent(Entity entity) {
+            getPayloads<T>();
+            m_commands.push_back({CommandKind::Remove, componentTypeId<T>(), entity, 0});
+        }
+
+        bool empty() const { return m_commands.empty(); }
+
+        // Applies every recorded command under a single exclusive structure lock and clears the buffer.
+        // Creations run first and destructions last, as one batch. Component changes in between are grouped by
+        // component type so each storage is touched in one pass, keeping the recorded order within a type.
+        void playback(ECSCoordinator &ecs) {
+            if (m_commands.empty())
+                return;
+
+            ecs.m_structureLock.AcquireWrite();
+
+            m_createdEntities.clear();
+            for (const Command &command : m_commands) {
+                if (command.kind == CommandKind::Create)
+                    m_createdEntities.push_back(ecs.createEntityUnlocked());
+            }
+
+            auto componentsEnd = std::stable_partition(m_commands.begin(), m_commands.end(), [](const Command &command) {
+                return command.kind == CommandKind::Add || command.kind == CommandKind::Remove;
+            });
+            std::stable_sort(m_commands.begin(), componentsEnd, [](const Command &a, const Command &b) {
+                return a.type < b.type;
+            });
+
+            for (auto it = m_commands.begin(); it != componentsEnd; ++it) {
+                Entity entity = resolve(it->entity);
+                if (!ecs.isAlive(entity))
+                    continue;
+
+                IComponentCommands &payloads = *m_payloads[it->type];
+                const bool present = ecs.m_entityManager->getSignature(entity).test(it->type);
+                if (it->kind == CommandKind::Add) {
+                    if (present)
+                        payloads.replace(ecs, entity, it->payloadIndex);
+                    else
+                        payloads.add(ecs, entity, it->payloadIndex);
+                } else if (present) {
+                    payloads.remove(ecs, entity);
+                }
+            }
+
+            m_destroyedEntities.clear();
+            for (auto it = componentsEnd; it != m_commands.end(); ++it) {
+                if (it->kind == CommandKind::Destroy)
+                    m_destroyedEntities.push_back(resolve(it->entity));
+            }
+            ecs.destroyEntitiesUnlocked(m_destroyedEntities.data(), m_destroyedEntities.size());
+
+            ecs.m_structureLock.ReleaseWrite();
+
+            clear();
+        }
+
+        // Drops every recorded command, keeping allocated capacity for the next phase.
+        void clear() {
+            m_commands.clear();
+            m_createdCount = 0;
+            for (auto &payloads : m_payloads) {
+                if (payloads)
+                    payloads->clear();
+            }
+        }
+
+    private:
+        enum class CommandKind : std::uint8_t {
+            Create,
+            Destroy,
+            Add,
+            Remove
+        };
+
+        struct Command {
+            CommandKind kind;
+            ComponentType type;
+            Entity entity;
+            std::size_t payloadIndex;
+        };
+
+        class IComponentCommands {
+        public:
+            virtual ~IComponentCommands() = default;
+
+            virtual void add(ECSCoordinator &ecs, Entity entity, std::size_t payloadIndex) = 0;
+
+            virtual void replace(ECSCoordinator &ecs, Entity entity, std::size_t payloadIndex) = 0;
+
+            virtual void remove(ECSCoordinator &ecs, Entity entity) = 0;
+
+            virtual void clear() = 0;
+        };
+
+        // Component values of the add commands of one type, stored contiguously
+        template<typename T>
+        class ComponentCommands : public IComponentCommands {
+        public:
+            void add(ECSCoordinator &ecs, Entity entity, std::size_t payloadIndex) override {
+                ecs.addComponentUnlocked<T>(entity, components[payloadIndex]);
+            }
+
+            void replace(ECSCoordinator &ecs, Entity entity, std::size_t payloadIndex) override {
+                if constexpr (!isTagComponent<T>) {
+                    ecs.storedComponent<T>(entity) = components[payloadIndex];
+                    ecs.markAdded<T>(entity);
+                }
+            }
+
+            void remove(ECSCoordinator &ecs, Entity entity) override {
+                ecs.removeComponentUnlocked<T>(entity);
+            }
+
+            void clear() override {
+                components.clear();
+            }
+
+            std::vector<T> components{};
+        };
+
+        template<typename T>
+        ComponentCommands<T> &getPayloads() {
+            std::unique_ptr<IComponentCommands> &payloads = m_payloads[componentTypeId<T>()];
+            if (!payloads)
+                payloads = std::make_unique<ComponentCommands<T> >();
+            return *static_cast<ComponentCommands<T> *>(payloads.get());
+        }
+
+        Entity resolve(Entity entity) const {
+            if (entityGeneration(entity) != RESERVED_GENERATION)
+                return entity;
+
+            assert(entityIndex(entity) < m_createdEntities.size() && "Placeholder entity from another command buffer.");
+            return m_createdEntities[entityIndex(entity)];
+        }
+
+        std::vector<Command> m_commands{};
+        std::array<std::unique_ptr<IComponentCommands>, MAX_COMPONENTS> m_payloads{};
+        std::vector<Entity> m_createdEntities{};
+        std::vector<Entity> m_destroyedEntities{};
+        std::uint32_t m_createdCount = 0;
+    };
+}
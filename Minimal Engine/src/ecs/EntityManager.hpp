@@ -1,39 +1,151 @@
 #pragma once
 
+#include <algorithm>
+#include <bitset>
+#include <cassert>
 #include <cstdint>
-#include <queue>
+#include <vector>
 
 namespace Minimal {
-    constexpr std::uint32_t MAX_ENTITIES = 5000;
-    using Entity = std::uint32_t;
+    // Upper bound on living entities unless the coordinator is configured otherwise
+    constexpr std::uint32_t DEFAULT_MAX_ENTITIES = 1u << 20;
+
+    // Entity handles pack a 32-bit slot index in the low half and a 32-bit generation in the high half.
+    // The generation is bumped every time a slot is recycled, so stale handles never alias new entities.
+    using Entity = std::uint64_t;
+    constexpr Entity INVALID_ENTITY = UINT64_MAX;
+    // Never handed out by EntityManager, reserved for handles that are not backed by a slot yet
+    constexpr std::uint32_t RESERVED_GENERATION = UINT32_MAX;
+
+    constexpr std::uint32_t entityIndex(Entity entity) { return static_cast<std::uint32_t>(entity); }
+
+    constexpr std::uint32_t entityGeneration(Entity entity) { return static_cast<std::uint32_t>(entity >> 32); }
+
+    constexpr Entity makeEntity(std::uint32_t index, std::uint32_t generation) {
+        return static_cast<Entity>(generation) << 32 | index;
+    }
+
+    constexpr std::size_t MAX_COMPONENTS = 32;
+    using ComponentType = std::uint8_t;
+    // One bit per registered component type, set when the entity has that component
+    using Signature = std::bitset<MAX_COMPONENTS>;
 
     class EntityManager {
     public:
-        EntityManager() {
-            for (Entity e = 0; e < MAX_ENTITIES; ++e) {
-                m_availableEntities.push(e);
-            }
-            m_livingEntityCount = 0;
+        explicit EntityManager(std::uint32_t maxEntities = DEFAULT_MAX_ENTITIES)
+            : m_maxEntities(maxEntities) {
         }
 
+        // Returns INVALID_ENTITY once maxEntities entities are alive.
         Entity createEntity() {
-            Entity id = m_availableEntities.front();
-            m_availableEntities.pop();
+            if (m_livingEntityCount >= m_maxEntities)
+                return INVALID_ENTITY;
+
+            Entity entity;
+            if (m_freeHead != NO_FREE_SLOT) {
+                // Free slots store the next free index in place of their own, with the generation already bumped
+                std::uint32_t index = m_freeHead;
+                m_freeHead = entityIndex(m_slots[index]);
+                entity = makeEntity(index, entityGeneration(m_slots[index]));
+                m_slots[index] = entity;
+            }
+            else {
+                entity = makeEntity(static_cast<std::uint32_t>(m_slots.size()), 0);
+                m_slots.push_back(entity);
+                m_signatures.emplace_back();
+            }
+
             ++m_livingEntityCount;
-            return id;
+            return entity;
+        }
+
+        // Creates count entities at once, reusing free slots first and appending the rest in one resize. Stops at
+        // maxEntities living entities: returns how many were created, those are at the front of out and the rest
+        // of out is set to INVALID_ENTITY.
+        std::size_t createEntities(std::size_t count, Entity *out) {
+            const std::size_t available = m_maxEntities - m_livingEntityCount;
+            if (count > available) {
+                std::fill(out + available, out + count, INVALID_ENTITY);
+                count = available;
+            }
+
+            std::size_t created = 0;
+            for (; created < count && m_freeHead != NO_FREE_SLOT; ++created) {
+                std::uint32_t index = m_freeHead;
+                m_freeHead = entityIndex(m_slots[index]);
+                m_slots[index] = makeEntity(index, entityGeneration(m_slots[index]));
+                out[created] = m_slots[index];
+            }
+
+            const std::uint32_t first = static_cast<std::uint32_t>(m_slots.size());
+            const std::size_t fresh = count - created;
+            m_slots.resize(first + fresh);
+            m_signatures.resize(first + fresh);
+            for (std::uint32_t i = 0; i < fresh; ++i) {
+                m_slots[first + i] = makeEntity(first + i, 0);
+                out[created + i] = m_slots[first + i];
+            }
+
+            m_livingEntityCount += static_cast<std::uint32_t>(count);
+            return count;
         }
 
         void destroyEntity(Entity entity) {
-            m_availableEntities.push(entity);
+            assert(isAlive(entity) && "Destroying an entity that is not alive.");
+
+            std::uint32_t index = entityIndex(entity);
+            std::uint32_t generation = entityGeneration(entity) + 1;
+            if (generation == RESERVED_GENERATION)
+                generation = 0;
+
+            m_signatures[index].reset();
+            m_slots[index] = makeEntity(m_freeHead, generation);
+            m_freeHead = index;
             --m_livingEntityCount;
         }
 
+        // O(1) handle validation, cheap enough to use outside of debug builds.
+        bool isAlive(Entity entity) const {
+            const std::uint32_t index = entityIndex(entity);
+            return index < m_slots.size() && m_slots[index] == entity;
+        }
+
+        void setSignature(Entity entity, const Signature &signature) {
+            assert(isAlive(entity) && "Entity is not alive.");
+            m_signatures[entityIndex(entity)] = signature;
+        }
+
+        const Signature &getSignature(Entity entity) const {
+            assert(isAlive(entity) && "Entity is not alive.");
+            return m_signatures[entityIndex(entity)];
+        }
+
         int getEntityCount() const {
             return m_livingEntityCount;
         }
 
+        // Number of slots handed out so far, living or destroyed. Every entity index is below this value.
+        std::uint32_t getAllocatedEntityCount() const {
+            return static_cast<std::uint32_t>(m_slots.size());
+        }
+
+        // Handle currently stored in a slot. Only meaningful when isAlive() holds for the result.
+        Entity entityAt(std::uint32_t index) const {
+            return m_slots[index];
+        }
+
+        std::uint32_t getMaxEntities() const {
+            return m_maxEntities;
+        }
+
     private:
-        std::queue<Entity> m_availableEntities;
-        std::uint32_t m_livingEntityCount;
+        static constexpr std::uint32_t NO_FREE_SLOT = UINT32_MAX;
+
+        // Living slots hold their own handle, free slots double as the links of the free list
+        std::vector<Entity> m_slots{};
+        std::vector<Signature> m_signatures{};
+        std::uint32_t m_freeHead = NO_FREE_SLOT;
+        std::uint32_t m_livingEntityCount = 0;
+        std::uint32_t m_maxEntities;
     };
 }
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "ComponentManager.hpp"
+#include "ComponentTypeId.hpp"
+#include "Components.hpp"
+#include "EntityManager.hpp"
+
+namespace Minimal {
+    // Template for entities that share a set of components: a signature plus the value each instance starts out
+    // with for every component in it. ECSCoordinator::instantiate() spawns instances in bulk, copying each value
+    // into storage as one block instead of moving every entity through an archetype per added component.
+    // Like createEntity(), every instance has a TransformComponent, which defaults to the identity.
+    //
+    // Values are shared between copies of a prefab and never modified, set() replaces them.
+    class Prefab {
+        friend class ECSCoordinator;
+
+    public:
+        Prefab() {
+            set<TransformComponent>({});
+        }
+
+        // Adds the component to the prefab, or replaces its default value.
+        template<typename T>
+        Prefab &set(const T &value) {
+            const ComponentType type = componentTypeId<T>();
+            auto it = findComponent(type);
+            if (it == m_components.end()) {
+                m_signature.set(type);
+                m_components.push_back({type, nullptr, &addCopies<T>});
+                it = m_components.end() - 1;
+            }
+            it->value = std::make_shared<std::remove_cv_t<T> >(value);
+            return *this;
+        }
+
+        template<typename T>
+        bool has() const {
+            return m_signature.test(componentTypeId<T>());
+        }
+
+        template<typename T>
+        const T &get() const {
+            auto it = findComponent(componentTypeId<T>());
+            assert(it != m_components.end() && "Prefab does not contain component.");
+            return *static_cast<const T *>(it->value.get());
+        }
+
+        const Signature &getSignature() const { return m_signature; }
+
+    private:
+        struct ComponentDefault {
+            ComponentType type;
+            std::shared_ptr<const void> value;
+            // Appends copies of the value for count entities to the type's component array
+            void (*addToArray)(ComponentManager &, const Entity *, std::size_t, const void *, std::uint32_t);
+        };
+
+        template<typename T>
+        static void addCopies(ComponentManager &manager, const Entity *entities, std::size_t count, const void *value,
+                              std::uint32_t version) {
+            manager.addComponentCopies<std::remove_cv_t<T> >(entities, *static_cast<const T *>(value), count, version);
+        }
+
+        std::vector<ComponentDefault>::iterator findComponent(ComponentType type) {
+            return std::find_if(m_components.begin(), m_components.end(), [type](const ComponentDefault &component) {
+                return component.type == type;
+            });
+        }
+
+        std::vector<ComponentDefault>::const_iterator findComponent(ComponentType type) const {
+            return std::find_if(m_components.begin(), m_components.end(), [type](const ComponentDefault &component) {
+                return component.type == type;
+            });
+        }
+
+        Signature m_signature{};
+        std::vector<ComponentDefault> m_components{};
+    };
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Archetype.hpp"
+#include "ECSCoordinator.hpp"
+#include "SparseSet.hpp"
+#include "View.hpp"
+
+namespace Minimal {
+    // Persistent query over every entity that has all of Ts, meant to be created once, e.g. as a system member,
+    // and iterated every frame. The matches are cached and patched by the structural changes that affect them:
+    // with archetype storage the list of matching archetypes grows when one is created, with per-type arrays the
+    // matching entity set is updated when one of Ts is added or removed or a matching entity is destroyed.
+    // Setting up a view over a stable world costs nothing beyond the view itself.
+    //
+    // Registration takes the structure lock, so queries cannot be created or destroyed while a task holds an
+    // access set. Their views follow the same rules as ECSCoordinator::view().
+    template<typename... Ts>
+    class Query {
+        static_assert(sizeof...(Ts) > 0, "A query needs at least one component type.");
+
+    public:
+        explicit Query(ECSCoordinator &ecs)
+            : m_ecs(ecs), m_archetypes(std::make_shared<std::vector<Archetype *> >()) {
+            m_ecs.registerQuery(m_ecs.makeSignature<std::remove_const_t<Ts>...>(), m_entities, *m_archetypes);
+        }
+
+        ~Query() {
+            m_ecs.unregisterQuery(m_entities, *m_archetypes);
+        }
+
+        Query(const Query &) = delete;
+
+        Query &operator=(const Query &) = delete;
+
+        View<Ts...> view() const {
+            if (m_ecs.getStorageMode() == StorageMode::Archetype)
+                return m_ecs.view<Ts...>(std::shared_ptr<const std::vector<Archetype *> >(m_archetypes));
+
+            return m_ecs.view<Ts...>(m_entities);
+        }
+
+        // Number of matching entities.
+        std::size_t size() const {
+            if (m_ecs.getStorageMode() != StorageMode::Archetype)
+                return m_entities.size();
+
+            std::size_t count = 0;
+            for (const Archetype *archetype : *m_archetypes) {
+                count += archetype->size();
+            }
+            return count;
+        }
+
+        // Calls func for every match, either as func(entity, components...) or func(components...).
+        template<typename Func>
+        void each(Func &&func) const {
+            view().each(std::forward<Func>(func));
+        }
+
+        // Same as ECSCoordinator::parallelEach() over the cached matches.
+        template<typename Func>
+        void parallelEach(Func &&func, std::size_t grainSize = ECSCoordinator::DEFAULT_GRAIN_SIZE) const {
+            m_ecs.parallelEach(view(), std::forward<Func>(func), grainSize);
+        }
+
+    private:
+        ECSCoordinator &m_ecs;
+        // Cached matches for per-type arrays and for archetype storage, only the one in use is filled
+        SparseSet m_entities{};
+        std::shared_ptr<std::vector<Archetype *> > m_archetypes;
+    };
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "EntityManager.hpp"
+
+namespace Minimal {
+    // Maps entities to a packed index range [0, size). The sparse side is keyed by entity index and split into
+    // fixed-size pages that are only allocated once an entity inside them is inserted, the dense side stores the
+    // full handles in index order so the set can be iterated linearly.
+    class SparseSet {
+    public:
+        static constexpr std::size_t PAGE_SIZE = 4096;
+        static constexpr std::uint32_t INVALID_INDEX = UINT32_MAX;
+
+        explicit SparseSet(std::size_t reservedCapacity = 0) {
+            m_dense.reserve(reservedCapacity);
+        }
+
+        // Also rejects stale handles whose slot has since been reused by a newer generation.
+        bool contains(Entity entity) const {
+            const std::uint32_t index = entityIndex(entity);
+            const std::size_t page = index / PAGE_SIZE;
+            if (page >= m_sparse.size() || m_sparse[page] == nullptr)
+                return false;
+
+            const std::uint32_t dense = m_sparse[page][index % PAGE_SIZE];
+            return dense != INVALID_INDEX && m_dense[dense] == entity;
+        }
+
+        std::size_t indexOf(Entity entity) const {
+            assert(contains(entity) && "Entity is not in the set.");
+            const std::uint32_t index = entityIndex(entity);
+            return m_sparse[index / PAGE_SIZE][index % PAGE_SIZE];
+        }
+
+        // Appends the entity and returns its dense index.
+        std::size_t insert(Entity entity) {
+            assert(!contains(entity) && "Entity inserted into the set more than once.");
+
+            const std::size_t index = m_dense.size();
+            sparseSlot(entity) = static_cast<std::uint32_t>(index);
+            m_dense.push_back(entity);
+            return index;
+        }
+
+        void reserve(std::size_t capacity) {
+            m_dense.reserve(capacity);
+        }
+
+        // Removes the entity by moving the last dense entry into its slot.
+        // Returns the dense index that was freed, the caller mirrors the move for any parallel data arrays.
+        std::size_t erase(Entity entity) {
+            const std::size_t index = indexOf(entity);
+            const Entity last = m_dense.back();
+
+            m_dense[index] = last;
+            sparseSlot(last) = static_cast<std::uint32_t>(index);
+            sparseSlot(entity) = INVALID_INDEX;
+            m_dense.pop_back();
+            return index;
+        }
+
+        // Exchanges two dense entries, the caller mirrors the swap for any parallel data arrays.
+        void swapIndices(std::size_t a, std::size_t b) {
+            std::swap(m_dense[a], m_dense[b]);
+            sparseSlot(m_dense[a]) = static_cast<std::uint32_t>(a);
+            sparseSlot(m_dense[b]) = static_cast<std::uint32_t>(b);
+        }
+
+        Entity entityAt(std::size_t index) const { return m_dense[index]; }
+
+        const Entity *data() const { return m_dense.data(); }
+
+        std::size_t size() const { return m_dense.size(); }
+
+        bool empty() const { return m_dense.empty(); }
+
+        std::vector<Entity>::const_iterator begin() const { return m_dense.begin(); }
+
+        std::vector<Entity>::const_iterator end() const { return m_dense.end(); }
+
+    private:
+        std::uint32_t &sparseSlot(Entity entity) {
+            const std::uint32_t index = entityIndex(entity);
+            const std::size_t page = index / PAGE_SIZE;
+            if (page >= m_sparse.size())
+                m_sparse.resize(page + 1);
+
+            if (m_sparse[page] == nullptr) {
+                m_sparse[page] = std::make_unique<std::uint32_t[]>(PAGE_SIZE);
+                std::fill_n(m_sparse[page].get(), PAGE_SIZE, INVALID_INDEX);
+            }
+
+            return m_sparse[page][index % PAGE_SIZE];
+        }
+
+        std::vector<std::unique_ptr<std::uint32_t[]> > m_sparse{};
+        std::vector<Entity> m_dense{};
+    };
+}
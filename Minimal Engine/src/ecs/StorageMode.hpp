@@ -0,0 +1,10 @@
+#pragma once
+
+namespace Minimal {
+    enum class StorageMode {
+        // One dense array per component type
+        ComponentArray,
+        // Entities with the same signature packed into chunks, one column per component type
+        Archetype
+    };
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace Minimal {
+    // Orders component storage can be sorted into, see ECSCoordinator::sortStorage().
+    enum class StorageOrder {
+        // By entity index, so iteration follows slot order
+        EntityIndex,
+        // Along a Morton (Z-order) curve through TransformComponent::position, so entities that are close in the
+        // world are close in memory
+        Morton
+    };
+
+    // Interleaves the cell coordinates of a position into a 63-bit Morton code. Positions are quantized to cells
+    // of cellSize units; 21 bits per axis cover 2^20 cells on either side of the origin, coordinates beyond that
+    // are clamped.
+    inline std::uint64_t mortonCode(float x, float y, float z, float cellSize) {
+        constexpr std::int64_t HALF_RANGE = 1 << 20;
+
+        auto cell = [cellSize](float coordinate) {
+            std::int64_t value = static_cast<std::int64_t>(std::floor(coordinate / cellSize)) + HALF_RANGE;
+            value = value < 0 ? 0 : value;
+            value = value > 2 * HALF_RANGE - 1 ? 2 * HALF_RANGE - 1 : value;
+            return static_cast<std::uint64_t>(value);
+        };
+
+        // Spreads the low 21 bits so two zero bits separate each of them
+        auto spread = [](std::uint64_t value) {
+            value &= 0x1fffff;
+            value = (value | value << 32) & 0x1f00000000ffff;
+            value = (value | value << 16) & 0x1f0000ff0000ff;
+            value = (value | value << 8) & 0x100f00f00f00f00f;
+            value = (value | value << 4) & 0x10c30c30c30c30c3;
+            value = (value | value << 2) & 0x1249249249249249;
+            return value;
+        };
+
+        return spread(cell(x)) | spread(cell(y)) << 1 | spread(cell(z)) << 2;
+    }
+
+    // Comb sort that can stop after any number of comparisons and resume where it left off. Shrinking gaps move
+    // far-off entries close to their place in about n log n comparisons, after which the sorter stays at gap 1
+    // and alternates directions like a cocktail shaker sort. That repairs the small amount of disorder a frame
+    // introduces in a pass or two, since one pass carries an entry any distance. Gap 1 passes only fix a few
+    // entries each, so when one finds more separate runs of unordered entries than combing takes passes,
+    // e.g. after many entities were added, the sorter starts combing again.
+    class IncrementalSorter {
+    public:
+        // Compares up to budget pairs of entries, swapping those out of order. Returns the number of comparisons
+        // made, which is less than budget once a gap 1 pass in each direction swapped nothing.
+        template<typename Key, typename Swap>
+        std::size_t run(std::size_t size, std::size_t budget, Key &&keyAt, Swap &&swap) {
+            if (size < 2)
+                return 0;
+
+            // First run, or the storage shrank since the last call
+            if (m_gap == 0 || m_gap >= size)
+                startCombing(size);
+            else if (m_cursor + m_gap >= size)
+                startPass(size);
+
+            std::size_t steps = 0;
+            while (steps < budget) {
+                const bool swapped = keyAt(m_cursor + m_gap) < keyAt(m_cursor);
+                if (swapped) {
+                    swap(m_cursor, m_cursor + m_gap);
+                    if (!m_previousSwapped)
+                        ++m_runs;
+                }
+                m_previousSwapped = swapped;
+                ++steps;
+
+                const bool passDone = m_forward ? m_cursor + m_gap == size - 1 : m_cursor == 0;
+                if (!passDone) {
+                    m_forward ? ++m_cursor : --m_cursor;
+                    continue;
+                }
+
+                if (m_gap > 1) {
+                    m_gap = shrink(m_gap);
+                    startPass(size);
+                    continue;
+                }
+                if (!m_justCombed && m_runs > combPasses(size)) {
+                    startCombing(size);
+                    continue;
+                }
+
+                m_justCombed = false;
+                m_cleanPasses = m_runs == 0 ? m_cleanPasses + 1 : 0;
+                m_forward = !m_forward;
+                startPass(size);
+                if (m_cleanPasses >= 2) {
+                    m_cleanPasses = 0;
+                    break;
+                }
+            }
+            return steps;
+        }
+
+    private:
+        static std::size_t shrink(std::size_t gap) {
+            return gap * 10 / 13 > 1 ? gap * 10 / 13 : 1;
+        }
+
+        // Passes a full comb over size entries takes, each of them costs about as much as a gap 1 pass
+        static std::size_t combPasses(std::size_t size) {
+            std::size_t passes = 1;
+            for (std::size_t gap = shrink(size); gap > 1; gap = shrink(gap)) {
+                ++passes;
+            }
+            return passes;
+        }
+
+        void startCombing(std::size_t size) {
+            m_gap = shrink(size);
+            m_forward = true;
+            m_justCombed = true;
+            m_cleanPasses = 0;
+            startPass(size);
+        }
+
+        // Passes with a gap above 1 always run forward
+        void startPass(std::size_t size) {
+            m_cursor = m_forward || m_gap > 1 ? 0 : size - 2;
+            m_runs = 0;
+            m_previousSwapped = false;
+        }
+
+        std::size_t m_gap = 0;
+        std::size_t m_cursor = 0;
+        bool m_forward = true;
+        // Separate runs of swaps in the current pass, an entry carried along several positions counts once
+        std::size_t m_runs = 0;
+        bool m_previousSwapped = false;
+        // The first gap 1 pass after combing still finds its leftovers and never restarts it
+        bool m_justCombed = false;
+        int m_cleanPasses = 0;
+    };
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+#include "EntityManager.hpp"
+#include "SparseSet.hpp"
+
+namespace Minimal {
+    // Keeps the entity set of every registered system in sync with entity signatures, so systems only
+    // iterate the entities that have all of their required components.
+    class SystemManager {
+    public:
+        void registerSystem(SparseSet &entities, const Signature &signature) {
+            assert(signature.any() && "System signature must require at least one component.");
+            assert(findSystem(entities) == m_systems.end() && "Registering system more than once.");
+
+            m_systems.push_back({signature, &entities});
+        }
+
+        void unregisterSystem(SparseSet &entities) {
+            auto it = findSystem(entities);
+            assert(it != m_systems.end() && "Unregistering unknown system.");
+            m_systems.erase(it);
+        }
+
+        // Only systems whose signature contains the added or removed component type can be affected.
+        void entitySignatureChanged(Entity entity, const Signature &entitySignature, ComponentType changedType) {
+            for (const SystemRecord &system : m_systems) {
+                if (!system.signature.test(changedType))
+                    continue;
+
+                const bool matches = (entitySignature & system.signature) == system.signature;
+                const bool contains = system.entities->contains(entity);
+                if (matches && !contains)
+                    system.entities->insert(entity);
+                else if (!matches && contains)
+                    system.entities->erase(entity);
+            }
+        }
+
+        // Adds a new entity that starts out with the given signature to every system it matches.
+        void entityCreated(Entity entity, const Signature &entitySignature) {
+            for (const SystemRecord &system : m_systems) {
+                if ((entitySignature & system.signature) == system.signature)
+                    system.entities->insert(entity);
+            }
+        }
+
+        // Takes the signature the entity had, only the systems it matched hold the entity.
+        void entityDestroyed(Entity entity, const Signature &entitySignature) {
+            for (const SystemRecord &system : m_systems) {
+                if ((entitySignature & system.signature) == system.signature)
+                    system.entities->erase(entity);
+            }
+        }
+
+    private:
+        struct SystemRecord {
+            Signature signature;
+            SparseSet *entities;
+        };
+
+        std::vector<SystemRecord>::iterator findSystem(const SparseSet &entities) {
+            return std::find_if(m_systems.begin(), m_systems.end(), [&entities](const SystemRecord &system) {
+                return system.entities == &entities;
+            });
+        }
+
+        std::vector<SystemRecord> m_systems{};
+    };
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <type_traits>
+
+namespace Minimal {
+    // Components without data members are tags. Storage only records which entities have them, so they can
+    // partition queries without costing memory per entity. They cannot be fetched with getComponent.
+    template<typename T>
+    constexpr bool isTagComponent = std::is_empty_v<std::remove_cv_t<T> >;
+
+    // Tags carry no state, so every entity shares this instance wherever a view hands a tag out.
+    template<typename T>
+    T &tagInstance() {
+        static_assert(isTagComponent<T>, "Only tag components share an instance.");
+        static std::remove_cv_t<T> instance{};
+        return instance;
+    }
+}
@@ -0,0 +1,395 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Archetype.hpp"
+#include "ArchetypeManager.hpp"
+#include "ComponentArray.hpp"
+#include "TagComponent.hpp"
+
+namespace Minimal {
+    // Iterates every entity that has all of Ts, yielding the entity and references to its components.
+    // With per-type arrays iteration is driven by the smallest dense array and the others are probed through
+    // their sparse sets; with archetype storage the matching chunks are streamed column by column.
+    // A view can also be driven by an entity set that is known to match, such as a system's entity list.
+    //
+    // Components requested as const T are read only. Every other component handed out by the view is stamped
+    // with the view's change version, per element with per-type arrays and per chunk with archetype storage.
+    // Tag components restrict the view to the tagged entities and are handed out as a shared instance.
+    template<typename... Ts>
+    class View {
+        static_assert(sizeof...(Ts) > 0, "A view needs at least one component type.");
+
+        template<typename T>
+        using Array = ComponentArray<std::remove_const_t<T> >;
+
+    public:
+        using value_type = std::tuple<Entity, Ts &...>;
+
+        View(std::uint32_t version, Array<Ts> &... arrays)
+            : m_arrays{&arrays...}, m_version(version) {
+            const SparseSet *candidates[] = {&arrays.getEntities()...};
+            m_driver = candidates[0];
+            for (const SparseSet *candidate : candidates) {
+                if (candidate->size() < m_driver->size())
+                    m_driver = candidate;
+            }
+        }
+
+        View(std::uint32_t version, const SparseSet &entities, Array<Ts> &... arrays)
+            : m_arrays{&arrays...}, m_driver(&entities), m_probeDriver(false), m_version(version) {
+        }
+
+        // The archetype list is shared rather than copied, so views over a query's cached list cost no allocation.
+        View(std::uint32_t version, std::shared_ptr<const std::vector<Archetype *> > archetypes,
+             const std::array<ComponentType, sizeof...(Ts)> &types)
+            : m_archetypes(std::move(archetypes)), m_types(types), m_version(version) {
+        }
+
+        View(std::uint32_t version, const SparseSet &entities, ArchetypeManager &archetypeManager,
+             const std::array<ComponentType, sizeof...(Ts)> &types)
+            : m_driver(&entities), m_probeDriver(false), m_archetypeManager(&archetypeManager), m_types(types),
+              m_version(version) {
+        }
+
+        // Restricts the view to entities whose T changed after the given version. With archetype storage the
+        // filter works per chunk, so unchanged entities that share a chunk with a changed one are included too.
+        template<typename T>
+        View changedSince(std::uint32_t version) const {
+            constexpr std::size_t index = indexOf<std::remove_const_t<T> >();
+            static_assert(index < sizeof...(Ts), "Change filter type is not part of the view.");
+            static_assert(!isTagComponent<T>, "Tag components are not change tracked.");
+
+            View filtered = *this;
+            filtered.m_filterChanged = true;
+            filtered.m_filterIndex = index;
+            filtered.m_changedSince = version;
+            return filtered;
+        }
+
+        class Iterator {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = View::value_type;
+            using difference_type = std::ptrdiff_t;
+            using pointer = void;
+            using reference = value_type;
+
+            Iterator(const View *view, bool atEnd) : m_view(view) {
+                if (m_view->streamsChunks()) {
+                    m_archetype = atEnd ? m_view->m_archetypes->size() : 0;
+                    seekChunk();
+                }
+                else {
+                    m_index = atEnd ? m_view->m_driver->size() : 0;
+                    skipIncomplete();
+                }
+            }
+
+            value_type operator*() const {
+                if (m_view->streamsChunks())
+                    return dereferenceChunk(std::index_sequence_for<Ts...>{});
+
+                return m_view->fetch(m_view->m_driver->entityAt(m_index), std::index_sequence_for<Ts...>{});
+            }
+
+            Iterator &operator++() {
+                if (m_view->streamsChunks()) {
+                    if (++m_row == m_chunkSize) {
+                        m_row = 0;
+                        ++m_chunk;
+                        seekChunk();
+                    }
+                }
+                else {
+                    ++m_index;
+                    skipIncomplete();
+                }
+                return *this;
+            }
+
+            Iterator operator++(int) {
+                Iterator previous = *this;
+                ++*this;
+                return previous;
+            }
+
+            bool operator==(const Iterator &other) const {
+                return m_index == other.m_index
+                       && m_archetype == other.m_archetype
+                       && m_chunk == other.m_chunk
+                       && m_row == other.m_row;
+            }
+
+            bool operator!=(const Iterator &other) const { return !(*this == other); }
+
+        private:
+            void skipIncomplete() {
+                const SparseSet &driver = *m_view->m_driver;
+                while (m_index < driver.size() && !m_view->matches(driver.entityAt(m_index))) {
+                    ++m_index;
+                }
+            }
+
+            // Moves to the first non-empty matching chunk at or after the current position and caches its columns.
+            void seekChunk() {
+                const auto &archetypes = *m_view->m_archetypes;
+                while (m_archetype < archetypes.size()) {
+                    Archetype &archetype = *archetypes[m_archetype];
+                    if (m_chunk < archetype.chunkCount()) {
+                        if (!m_view->chunkMatches(archetype, m_chunk)) {
+                            ++m_chunk;
+                            continue;
+                        }
+
+                        m_chunkSize = archetype.chunkSize(m_chunk);
+                        m_entities = archetype.entitiesOf(m_chunk);
+                        m_columns = m_view->chunkColumns(archetype, m_chunk, std::index_sequence_for<Ts...>{});
+                        return;
+                    }
+
+                    ++m_archetype;
+                    m_chunk = 0;
+                }
+                m_chunk = 0;
+            }
+
+            template<std::size_t... Is>
+            value_type dereferenceChunk(std::index_sequence<Is...>) const {
+                return value_type(m_entities[m_row], elementAt<Is>(m_columns, m_row)...);
+            }
+
+            const View *m_view;
+
+            std::size_t m_index = 0;
+
+            std::size_t m_archetype = 0;
+            std::size_t m_chunk = 0;
+            std::size_t m_row = 0;
+            std::size_t m_chunkSize = 0;
+            Entity *m_entities = nullptr;
+            std::tuple<Ts *...> m_columns{};
+        };
+
+        Iterator begin() const { return Iterator(this, false); }
+
+        Iterator end() const { return Iterator(this, true); }
+
+        // Calls func(entity, components...) or func(components...) for every matching entity.
+        template<typename Func>
+        void each(Func &&func) const {
+            if (streamsChunks()) {
+                for (Archetype *archetype : *m_archetypes) {
+                    for (std::size_t chunk = 0; chunk < archetype->chunkCount(); ++chunk) {
+                        if (chunkMatches(*archetype, chunk))
+                            eachInChunk(*archetype, chunk, func, std::index_sequence_for<Ts...>{});
+                    }
+                }
+                return;
+            }
+
+            const SparseSet &driver = *m_driver;
+            for (std::size_t index = 0; index < driver.size(); ++index) {
+                Entity entity = driver.entityAt(index);
+                if (matches(entity))
+                    std::apply([&func](Entity e, Ts &... components) { invoke(func, e, components...); },
+                               fetch(entity, std::index_sequence_for<Ts...>{}));
+            }
+        }
+
+        // Contiguous slice of a view that can be iterated independently of the others. Indexes the driving
+        // entity set, or a run of chunks within one archetype when chunks are streamed.
+        struct Range {
+            std::size_t archetype = 0;
+            std::size_t begin = 0;
+            std::size_t end = 0;
+        };
+
+        // Splits the view into ranges of roughly grainSize entities. Chunks are never split and a range never
+        // spans two archetypes, so ranges can hold more or fewer entities than asked for.
+        std::vector<Range> split(std::size_t grainSize) const {
+            assert(grainSize > 0 && "Grain size must be positive.");
+
+            std::vector<Range> ranges;
+            if (!streamsChunks()) {
+                for (std::size_t begin = 0; begin < m_driver->size(); begin += grainSize) {
+                    ranges.push_back({0, begin, std::min(begin + grainSize, m_driver->size())});
+                }
+                return ranges;
+            }
+
+            for (std::size_t archetype = 0; archetype < m_archetypes->size(); ++archetype) {
+                const Archetype &chunks = *(*m_archetypes)[archetype];
+                std::size_t begin = 0;
+                std::size_t entities = 0;
+                for (std::size_t chunk = 0; chunk < chunks.chunkCount(); ++chunk) {
+                    entities += chunks.chunkSize(chunk);
+                    if (entities >= grainSize) {
+                        ranges.push_back({archetype, begin, chunk + 1});
+                        begin = chunk + 1;
+                        entities = 0;
+                    }
+                }
+                if (entities > 0)
+                    ranges.push_back({archetype, begin, chunks.chunkCount()});
+            }
+            return ranges;
+        }
+
+        // Same as each(func), restricted to one range returned by split().
+        template<typename Func>
+        void each(const Range &range, Func &&func) const {
+            if (streamsChunks()) {
+                Archetype &archetype = *(*m_archetypes)[range.archetype];
+                for (std::size_t chunk = range.begin; chunk < range.end; ++chunk) {
+                    if (chunkMatches(archetype, chunk))
+                        eachInChunk(archetype, chunk, func, std::index_sequence_for<Ts...>{});
+                }
+                return;
+            }
+
+            for (std::size_t index = range.begin; index < range.end; ++index) {
+                Entity entity = m_driver->entityAt(index);
+                if (matches(entity))
+                    std::apply([&func](Entity e, Ts &... components) { invoke(func, e, components...); },
+                               fetch(entity, std::index_sequence_for<Ts...>{}));
+            }
+        }
+
+        template<typename Func>
+        static void invoke(Func &func, Entity entity, Ts &... components) {
+            if constexpr (std::is_invocable_v<Func &, Entity, Ts &...>)
+                func(entity, components...);
+            else
+                func(components...);
+        }
+
+    private:
+        template<typename T, std::size_t... Is>
+        static constexpr std::size_t indexOf(std::index_sequence<Is...>) {
+            std::size_t index = sizeof...(Ts);
+            ((std::is_same_v<T, std::remove_const_t<Ts> > && index == sizeof...(Ts) ? index = Is : 0), ...);
+            return index;
+        }
+
+        template<typename T>
+        static constexpr std::size_t indexOf() { return indexOf<T>(std::index_sequence_for<Ts...>{}); }
+
+        bool streamsChunks() const { return m_driver == nullptr; }
+
+        bool matches(Entity entity) const {
+            if (m_probeDriver && !hasAll(entity, std::index_sequence_for<Ts...>{}))
+                return false;
+            return !m_filterChanged || changeVersionOf(entity, std::index_sequence_for<Ts...>{}) > m_changedSince;
+        }
+
+        // By position, a view may name the same component twice, e.g. as T and const T
+        template<std::size_t... Is>
+        bool hasAll(Entity entity, std::index_sequence<Is...>) const {
+            return (... && std::get<Is>(m_arrays)->hasData(entity));
+        }
+
+        bool chunkMatches(Archetype &archetype, std::size_t chunk) const {
+            return !m_filterChanged || archetype.getChunkVersion(chunk, m_types[m_filterIndex]) > m_changedSince;
+        }
+
+        template<std::size_t... Is>
+        std::uint32_t changeVersionOf(Entity entity, std::index_sequence<Is...>) const {
+            if (m_archetypeManager != nullptr)
+                return m_archetypeManager->getChangeVersion(entity, m_types[m_filterIndex]);
+
+            std::uint32_t version = 0;
+            ((Is == m_filterIndex ? version = std::get<Is>(m_arrays)->getVersion(entity) : 0), ...);
+            return version;
+        }
+
+        template<std::size_t... Is>
+        value_type fetch(Entity entity, std::index_sequence<Is...>) const {
+            if (m_archetypeManager != nullptr)
+                return value_type(entity, fetchArchetype<Ts>(entity, m_types[Is])...);
+
+            return value_type(entity, fetchArray<Ts>(entity, *std::get<Is>(m_arrays))...);
+        }
+
+        template<typename T>
+        T &fetchArchetype(Entity entity, ComponentType type) const {
+            if constexpr (isTagComponent<T>)
+                return tagInstance<T>();
+            else {
+                if constexpr (!std::is_const_v<T>)
+                    m_archetypeManager->markChanged(entity, type, m_version);
+                return *static_cast<T *>(m_archetypeManager->getComponentData(entity, type));
+            }
+        }
+
+        template<typename T>
+        T &fetchArray(Entity entity, Array<T> &array) const {
+            if constexpr (std::is_const_v<T>)
+                return array.getData(entity);
+            else
+                return array.writeData(entity, m_version);
+        }
+
+        // Resolves the columns of a chunk and stamps the writable ones as changed. Tags have no column and
+        // resolve to their shared instance instead.
+        template<std::size_t... Is>
+        std::tuple<Ts *...> chunkColumns(Archetype &archetype, std::size_t chunk, std::index_sequence<Is...>) const {
+            ((std::is_const_v<Ts> || isTagComponent<Ts>
+                  ? void()
+                  : archetype.markChunkChanged(chunk, m_types[Is], m_version)), ...);
+            return std::tuple<Ts *...>(columnOf<Ts>(archetype, chunk, m_types[Is])...);
+        }
+
+        template<typename T>
+        static T *columnOf(Archetype &archetype, std::size_t chunk, ComponentType type) {
+            if constexpr (isTagComponent<T>)
+                return &tagInstance<T>();
+            else
+                return archetype.columnOf<std::remove_const_t<T> >(chunk, type);
+        }
+
+        template<std::size_t I>
+        static auto &elementAt(const std::tuple<Ts *...> &columns, std::size_t row) {
+            if constexpr (isTagComponent<std::tuple_element_t<I, std::tuple<Ts...> > >)
+                return *std::get<I>(columns);
+            else
+                return std::get<I>(columns)[row];
+        }
+
+        template<typename Func, std::size_t... Is>
+        void eachInChunk(Archetype &archetype, std::size_t chunk, Func &func, std::index_sequence<Is...>) const {
+            Entity *entities = archetype.entitiesOf(chunk);
+            std::tuple<Ts *...> columns = chunkColumns(archetype, chunk, std::index_sequence_for<Ts...>{});
+            const std::size_t count = archetype.chunkSize(chunk);
+            for (std::size_t row = 0; row < count; ++row) {
+                invoke(func, entities[row], elementAt<Is>(columns, row)...);
+            }
+        }
+
+        std::tuple<Array<Ts> *...> m_arrays{};
+        // Entity set the iteration is driven by, null when archetype chunks are streamed directly
+        const SparseSet *m_driver = nullptr;
+        bool m_probeDriver = true;
+
+        ArchetypeManager *m_archetypeManager = nullptr;
+        std::shared_ptr<const std::vector<Archetype *> > m_archetypes{};
+        std::array<ComponentType, sizeof...(Ts)> m_types{};
+
+        // Stamped onto every writable component handed out
+        std::uint32_t m_version = 0;
+
+        bool m_filterChanged = false;
+        std::size_t m_filterIndex = 0;
+        std::uint32_t m_changedSince = 0;
+    };
+}
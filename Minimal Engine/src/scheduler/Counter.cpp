@@ -3,7 +3,8 @@
 #include "Scheduler.h"
 
 Counter::Counter(int startValue) : 
-	count(startValue)
+	count(startValue),
+	nextFree(nullptr)
 {
 
 }
@@ -20,9 +21,15 @@ void Counter::Increment()
 }
 void Counter::Decrement()
 {
-	int oldValue = count.fetch_sub(1, std::memory_order_relaxed);
-	if(oldValue - 1 == 0)
-		Scheduler::RestoreFibersFromWaitList(this);
+	// Only the decrement that reaches zero has to restore waiting fibers, the others stay lock free
+	int value = count.load(std::memory_order_relaxed);
+	while(value > 1)
+	{
+		if(count.compare_exchange_weak(value, value - 1, std::memory_order_release, std::memory_order_relaxed))
+			return;
+	}
+
+	Scheduler::DecrementAndRestore(this);
 }
 
 int Counter::GetCount() const
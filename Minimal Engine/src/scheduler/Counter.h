@@ -1,11 +1,18 @@
 #pragma once
 
+#include <atomic>
 #include <mutex>
 
+#include "TaskFiber.h"
+
 class Counter
 {
 private:
 	std::atomic<int> count;
+	// Fibers waiting for the count to reach zero, guarded by the scheduler's wait list lock
+	TaskFiberList waiters;
+	// Next unused counter while on the scheduler's free list
+	Counter* nextFree;
 
 private:
 	Counter(int startValue = 0);
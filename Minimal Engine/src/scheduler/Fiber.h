@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+
+// Platform independent fibers: execution contexts with their own stack that are switched cooperatively on the
+// current thread. Windows uses the native fiber API; Linux switches contexts with a few lines of assembly on
+// x86-64 and AArch64 and falls back to ucontext elsewhere, with stacks mapped by mmap behind a guard page.
+//
+// A fiber may be resumed on a different thread than the one it was suspended on. Its entry point must never
+// return, it ends by switching away for good.
+class Fiber
+{
+public:
+	using EntryPoint = void (*)(void* parameter);
+
+	// Enough for task code without deep recursion, the memory is only committed as the stack grows
+	static constexpr size_t DEFAULT_STACK_SIZE = 256 * 1024;
+
+	// Turns the calling thread into a fiber so it can switch to others, returns its handle.
+	static void* ConvertCurrentThread();
+	// Undoes ConvertCurrentThread(), called on the thread's original fiber before the thread exits.
+	static void RevertCurrentThread();
+
+	// Creates a fiber that runs entryPoint(parameter) once it is first switched to.
+	static void* Create(size_t stackSize, EntryPoint entryPoint, void* parameter);
+	// Frees a fiber's stack and context. Must not be called for the fiber currently running.
+	static void Destroy(void* fiber);
+
+	// Suspends the current fiber and resumes the given one.
+	static void SwitchTo(void* fiber);
+	// nullptr on threads that have not been converted
+	static void* GetCurrent();
+};
@@ -0,0 +1,245 @@
+#ifndef _WIN32
+
+#include "Fiber.h"
+
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#if defined(__ELF__) && (defined(__x86_64__) || defined(__aarch64__))
+#define FIBER_ASSEMBLY_SWITCH 1
+#else
+#define FIBER_ASSEMBLY_SWITCH 0
+#include <ucontext.h>
+#endif
+
+#if FIBER_ASSEMBLY_SWITCH
+// Saves the callee-saved registers on the current stack, stores the stack pointer in *from, then loads the one of
+// the target and restores its registers. Caller-saved registers are spilled by the compiler around the call anyway.
+extern "C" void MinimalFiberSwitch(void** from, void* to);
+// First return address of a new fiber, calls the start function found in the restored registers with its context
+extern "C" void MinimalFiberEntry();
+
+#if defined(__x86_64__)
+asm(R"(
+	.text
+	.globl MinimalFiberSwitch
+	.hidden MinimalFiberSwitch
+	.type MinimalFiberSwitch, @function
+MinimalFiberSwitch:
+	pushq %rbp
+	pushq %rbx
+	pushq %r12
+	pushq %r13
+	pushq %r14
+	pushq %r15
+	subq $8, %rsp
+	stmxcsr (%rsp)
+	fnstcw 4(%rsp)
+	movq %rsp, (%rdi)
+	movq %rsi, %rsp
+	ldmxcsr (%rsp)
+	fldcw 4(%rsp)
+	addq $8, %rsp
+	popq %r15
+	popq %r14
+	popq %r13
+	popq %r12
+	popq %rbx
+	popq %rbp
+	ret
+	.size MinimalFiberSwitch, .-MinimalFiberSwitch
+
+	.globl MinimalFiberEntry
+	.hidden MinimalFiberEntry
+	.type MinimalFiberEntry, @function
+MinimalFiberEntry:
+	movq %r12, %rdi
+	andq $-16, %rsp
+	callq *%r13
+	ud2
+	.size MinimalFiberEntry, .-MinimalFiberEntry
+)");
+#else
+asm(R"(
+	.text
+	.globl MinimalFiberSwitch
+	.hidden MinimalFiberSwitch
+	.type MinimalFiberSwitch, %function
+MinimalFiberSwitch:
+	sub sp, sp, #160
+	stp x19, x20, [sp, #0]
+	stp x21, x22, [sp, #16]
+	stp x23, x24, [sp, #32]
+	stp x25, x26, [sp, #48]
+	stp x27, x28, [sp, #64]
+	stp x29, x30, [sp, #80]
+	stp d8, d9, [sp, #96]
+	stp d10, d11, [sp, #112]
+	stp d12, d13, [sp, #128]
+	stp d14, d15, [sp, #144]
+	mov x9, sp
+	str x9, [x0]
+	mov sp, x1
+	ldp x19, x20, [sp, #0]
+	ldp x21, x22, [sp, #16]
+	ldp x23, x24, [sp, #32]
+	ldp x25, x26, [sp, #48]
+	ldp x27, x28, [sp, #64]
+	ldp x29, x30, [sp, #80]
+	ldp d8, d9, [sp, #96]
+	ldp d10, d11, [sp, #112]
+	ldp d12, d13, [sp, #128]
+	ldp d14, d15, [sp, #144]
+	add sp, sp, #160
+	ret
+	.size MinimalFiberSwitch, .-MinimalFiberSwitch
+
+	.globl MinimalFiberEntry
+	.hidden MinimalFiberEntry
+	.type MinimalFiberEntry, %function
+MinimalFiberEntry:
+	mov x0, x19
+	blr x20
+	brk #0
+	.size MinimalFiberEntry, .-MinimalFiberEntry
+)");
+#endif
+#endif
+
+namespace
+{
+	struct FiberContext
+	{
+#if FIBER_ASSEMBLY_SWITCH
+		// Stack pointer of the suspended fiber, its registers are saved on top of the stack
+		void* stackPointer = nullptr;
+#else
+		ucontext_t context{};
+#endif
+		// Guard page followed by the stack, null for converted threads which keep their own stack
+		void* mapping = nullptr;
+		size_t mappingSize = 0;
+
+		Fiber::EntryPoint entryPoint = nullptr;
+		void* parameter = nullptr;
+	};
+
+	thread_local FiberContext* currentFiber = nullptr;
+
+	void FiberStart(FiberContext* context)
+	{
+		context->entryPoint(context->parameter);
+
+		assert(false && "Fiber entry point returned.");
+		std::abort();
+	}
+
+#if !FIBER_ASSEMBLY_SWITCH
+	// makecontext() only passes int arguments, the fiber being started is already the current one
+	void UContextStart()
+	{
+		FiberStart(currentFiber);
+	}
+#endif
+}
+
+void* Fiber::ConvertCurrentThread()
+{
+	assert(!currentFiber && "Thread has already been converted to a fiber.");
+	currentFiber = new FiberContext{};
+	return currentFiber;
+}
+void Fiber::RevertCurrentThread()
+{
+	assert(currentFiber && !currentFiber->mapping && "Only a converted thread's own fiber can be reverted.");
+	delete currentFiber;
+	currentFiber = nullptr;
+}
+
+void* Fiber::Create(size_t stackSize, EntryPoint entryPoint, void* parameter)
+{
+	const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+	const size_t stackBytes = (stackSize + pageSize - 1) / pageSize * pageSize;
+
+	// Stacks grow down, the inaccessible lowest page turns an overflow into a crash instead of silent corruption
+	void* mapping = mmap(nullptr, pageSize + stackBytes, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+	if(mapping == MAP_FAILED)
+		throw std::bad_alloc();
+	mprotect(mapping, pageSize, PROT_NONE);
+
+	FiberContext* context = new FiberContext{};
+	context->mapping = mapping;
+	context->mappingSize = pageSize + stackBytes;
+	context->entryPoint = entryPoint;
+	context->parameter = parameter;
+
+	char* stackBottom = static_cast<char*>(mapping) + pageSize;
+	char* stackTop = stackBottom + stackBytes;
+
+#if FIBER_ASSEMBLY_SWITCH && defined(__x86_64__)
+	// Frame popped by the first switch: control words, r15, r14, r13, r12, rbx, rbp, return address
+	uint64_t* frame = reinterpret_cast<uint64_t*>(stackTop) - 8;
+	frame[0] = 0x1F80 | (uint64_t(0x037F) << 32); // Default MXCSR and x87 control word
+	frame[1] = 0;
+	frame[2] = 0;
+	frame[3] = reinterpret_cast<uint64_t>(&FiberStart);
+	frame[4] = reinterpret_cast<uint64_t>(context);
+	frame[5] = 0;
+	frame[6] = 0;
+	frame[7] = reinterpret_cast<uint64_t>(&MinimalFiberEntry);
+	context->stackPointer = frame;
+#elif FIBER_ASSEMBLY_SWITCH
+	// Frame popped by the first switch: x19 to x30, then d8 to d15
+	uint64_t* frame = reinterpret_cast<uint64_t*>(stackTop) - 20;
+	for(int i = 0; i < 20; i++)
+		frame[i] = 0;
+	frame[0] = reinterpret_cast<uint64_t>(context);
+	frame[1] = reinterpret_cast<uint64_t>(&FiberStart);
+	frame[11] = reinterpret_cast<uint64_t>(&MinimalFiberEntry);
+	context->stackPointer = frame;
+#else
+	getcontext(&context->context);
+	context->context.uc_stack.ss_sp = stackBottom;
+	context->context.uc_stack.ss_size = stackBytes;
+	context->context.uc_link = nullptr;
+	makecontext(&context->context, UContextStart, 0);
+#endif
+
+	return context;
+}
+void Fiber::Destroy(void* fiber)
+{
+	FiberContext* context = static_cast<FiberContext*>(fiber);
+	assert(context != currentFiber && "Destroying the running fiber.");
+
+	if(context->mapping)
+		munmap(context->mapping, context->mappingSize);
+	delete context;
+}
+
+void Fiber::SwitchTo(void* fiber)
+{
+	FiberContext* from = currentFiber;
+	FiberContext* to = static_cast<FiberContext*>(fiber);
+	assert(from && "Thread has not been converted to a fiber.");
+
+	// The target may be resumed from another thread than it was suspended on, it becomes this thread's fiber
+	currentFiber = to;
+#if FIBER_ASSEMBLY_SWITCH
+	MinimalFiberSwitch(&from->stackPointer, to->stackPointer);
+#else
+	swapcontext(&from->context, &to->context);
+#endif
+}
+void* Fiber::GetCurrent()
+{
+	return currentFiber;
+}
+
+#endif
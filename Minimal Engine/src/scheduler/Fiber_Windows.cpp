@@ -0,0 +1,65 @@
+#ifdef _WIN32
+
+#include "Fiber.h"
+
+#include <cassert>
+
+#include "Windows.h"
+
+namespace
+{
+	// Native fibers call a WINAPI procedure, the context adapts it to Fiber::EntryPoint and doubles as fiber data
+	struct FiberContext
+	{
+		LPVOID fiber;
+		Fiber::EntryPoint entryPoint;
+		void* parameter;
+	};
+
+	VOID WINAPI FiberStart(LPVOID parameter)
+	{
+		FiberContext* context = static_cast<FiberContext*>(parameter);
+		context->entryPoint(context->parameter);
+
+		assert(false && "Fiber entry point returned.");
+	}
+}
+
+void* Fiber::ConvertCurrentThread()
+{
+	FiberContext* context = new FiberContext{};
+	context->fiber = ConvertThreadToFiber(context);
+	assert(context->fiber);
+	return context;
+}
+void Fiber::RevertCurrentThread()
+{
+	FiberContext* context = static_cast<FiberContext*>(GetFiberData());
+	ConvertFiberToThread();
+	delete context;
+}
+
+void* Fiber::Create(size_t stackSize, EntryPoint entryPoint, void* parameter)
+{
+	FiberContext* context = new FiberContext{nullptr, entryPoint, parameter};
+	context->fiber = CreateFiber(stackSize, FiberStart, context);
+	assert(context->fiber);
+	return context;
+}
+void Fiber::Destroy(void* fiber)
+{
+	FiberContext* context = static_cast<FiberContext*>(fiber);
+	DeleteFiber(context->fiber);
+	delete context;
+}
+
+void Fiber::SwitchTo(void* fiber)
+{
+	SwitchToFiber(static_cast<FiberContext*>(fiber)->fiber);
+}
+void* Fiber::GetCurrent()
+{
+	return IsThreadAFiber() ? GetFiberData() : nullptr;
+}
+
+#endif
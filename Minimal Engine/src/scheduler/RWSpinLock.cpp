@@ -0,0 +1,64 @@
+#include "RWSpinLock.h"
+
+#include <thread>
+
+RWSpinLock::RWSpinLock()
+	: state(0)
+{
+
+}
+RWSpinLock::~RWSpinLock()
+{
+
+}
+
+bool RWSpinLock::TryAcquireRead()
+{
+	uint32_t current = state.load(std::memory_order_relaxed);
+	if (current & WRITER_BIT)
+		return false;
+
+	// acquire on success so reads after the lock see the last writer's data
+	return state.compare_exchange_weak(current, current + 1, std::memory_order_acquire, std::memory_order_relaxed);
+}
+void RWSpinLock::AcquireRead()
+{
+	while (!TryAcquireRead())
+	{
+		std::this_thread::yield();
+	}
+}
+void RWSpinLock::ReleaseRead()
+{
+	state.fetch_sub(1, std::memory_order_release);
+}
+
+bool RWSpinLock::TryAcquireWrite()
+{
+	uint32_t expected = 0;
+	return state.compare_exchange_strong(expected, WRITER_BIT, std::memory_order_acquire, std::memory_order_relaxed);
+}
+void RWSpinLock::AcquireWrite()
+{
+	while (!TryAcquireWrite())
+	{
+		std::this_thread::yield();
+	}
+}
+void RWSpinLock::ReleaseWrite()
+{
+	state.store(0, std::memory_order_release);
+}
+
+bool RWSpinLock::IsLocked() const
+{
+	return state.load(std::memory_order_relaxed) != 0;
+}
+bool RWSpinLock::IsWriteLocked() const
+{
+	return (state.load(std::memory_order_relaxed) & WRITER_BIT) != 0;
+}
+uint32_t RWSpinLock::GetReaderCount() const
+{
+	return state.load(std::memory_order_relaxed) & ~WRITER_BIT;
+}
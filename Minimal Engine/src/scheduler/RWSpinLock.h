@@ -0,0 +1,32 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Reader/writer spin lock. Any number of readers may hold the lock at once,
+// a writer holds it exclusively. Writers are not given priority, so they can
+// be delayed for as long as readers keep overlapping.
+class RWSpinLock
+{
+private:
+	static constexpr uint32_t WRITER_BIT = 1u << 31;
+
+	// Writer bit plus the number of readers currently holding the lock
+	std::atomic<uint32_t> state;
+
+public:
+	RWSpinLock();
+	~RWSpinLock();
+
+	bool TryAcquireRead();
+	void AcquireRead();
+	void ReleaseRead();
+
+	bool TryAcquireWrite();
+	void AcquireWrite();
+	void ReleaseWrite();
+
+	bool IsLocked() const;
+	bool IsWriteLocked() const;
+	uint32_t GetReaderCount() const;
+};
@@ -6,15 +6,54 @@
 
 #include <cassert>
 
-#include "Windows.h"
+#include "Fiber.h"
 
 // The main worker fiber for the local thread
 thread_local void* localFiber;
 
+// Index of the local thread's queues in workerQueues, -1 on threads that are not workers
+thread_local int workerIndex = -1;
+// Picks the first victim to steal from, seeded per worker so thieves spread out
+thread_local uint32_t stealSeed;
+
+// Task fiber the worker fiber last switched to
+thread_local TaskFiber* runningFiber;
+// Fiber that switched back to the worker fiber to wait on a counter, put on the wait list by the worker fiber
+thread_local TaskFiber* pendingWaitFiber;
+thread_local Counter* pendingWaitCounter;
+// Task fiber that switched back to the worker fiber after finishing its task, put on the free list by the worker fiber
+thread_local TaskFiber* finishedFiber;
+
 static Scheduler* instance;
 
-Scheduler::Scheduler() : 
-	primaryFiber(nullptr)
+// Moves up to count nodes from the front of one free list to the front of another, returns how many were moved
+template<typename T>
+static size_t MoveFreeNodes(T*& source, T*& destination, size_t count)
+{
+	T* first = source;
+	T* last = nullptr;
+	size_t moved = 0;
+	for(T* node = source; node && moved < count; node = node->next)
+	{
+		last = node;
+		moved++;
+	}
+	if(moved == 0)
+		return 0;
+
+	source = last->next;
+	last->next = destination;
+	destination = first;
+	return moved;
+}
+
+Scheduler::Scheduler(size_t fiberPoolSize, size_t fiberStackSize) : 
+	primaryFiber(nullptr),
+	fiberPoolSize(fiberPoolSize),
+	fiberStackSize(fiberStackSize),
+	freeFibers(nullptr),
+	freeEntryParams(nullptr),
+	freeCounters(nullptr)
 {
 	
 }
@@ -27,6 +66,7 @@ Scheduler::~Scheduler()
 	}
 	counters.clear();
 
+	// Tasks still queued when the scheduler shut down never run, their params are freed with the blocks
 	DestroyFiberPool();
 }
 
@@ -34,10 +74,6 @@ void Scheduler::Startup()
 {
 	instance = this;
 
-	taskQueues.emplace(TaskPriority::LOW, std::queue<FiberEntryParams>());
-	taskQueues.emplace(TaskPriority::MEDIUM, std::queue<FiberEntryParams>());
-	taskQueues.emplace(TaskPriority::HIGH, std::queue<FiberEntryParams>());
-
 	InitializeFiberPool();
 }
 void Scheduler::Shutdown()
@@ -47,107 +83,151 @@ void Scheduler::Shutdown()
 
 void Scheduler::Run()
 {
-	static const int THREAD_COUNT = 2;
+	// One worker per core, the calling thread being one of them
+	const unsigned int coreCount = std::thread::hardware_concurrency();
+	const unsigned int threadCount = coreCount > 1 ? coreCount - 1 : 1;
 
-	primaryFiber = ConvertThreadToFiber(0);
+	// The calling thread is worker 0
+	for(unsigned int i = 0; i <= threadCount; i++)
+	{
+		workerQueues.push_back(std::make_unique<WorkerQueues>());
+		workerFreeLists.push_back(std::make_unique<WorkerFreeLists>());
+		taskBlockPools.push_back(std::make_unique<TaskBlockPool>());
+	}
+
+	primaryFiber = Fiber::ConvertCurrentThread();
 	localFiber = primaryFiber;
+	workerIndex = 0;
+	stealSeed = 1;
+	TaskBlockPool::SetCurrent(taskBlockPools[0].get());
 
 	// Launch all worker threads
-	for(int i = 0; i < THREAD_COUNT; i++)
-		threads.emplace_back([]()
+	for(unsigned int i = 0; i < threadCount; i++)
+		threads.emplace_back([this, i]()
 		{
-			localFiber = ConvertThreadToFiber(0);
+			localFiber = Fiber::ConvertCurrentThread();
+			workerIndex = static_cast<int>(i) + 1;
+			stealSeed = i + 2;
+			TaskBlockPool::SetCurrent(taskBlockPools[i + 1].get());
 			
 			ExecuteWorkerThread();
+
+			Fiber::RevertCurrentThread();
 		});
 
 	ExecuteWorkerThread();
+	workerIndex = -1;
+	TaskBlockPool::SetCurrent(nullptr);
 
 	/* Shutdown */
 
 	// Before shutdown, wait for all threads to complete
 	for(std::thread& t : threads)
 		t.join();
+
+	Fiber::RevertCurrentThread();
 }
 void Scheduler::ExecuteWorkerThread()
 {
 	while(!instance->shouldTerminate)
 	{
-		//instance->cv_taskAvailable.wait(,);
-		while(instance->taskQueues[TaskPriority::LOW].size() == 0 
-			&& instance->taskQueues[TaskPriority::MEDIUM].size() == 0 
-			&& instance->taskQueues[TaskPriority::HIGH].size() == 0 
-			&& instance->restoredFibersQueue.size() == 0
-			&& !instance->shouldTerminate)
-			std::this_thread::yield();
-
 		// If there is a restored fiber available
-		if(instance->restoredFibersQueue.size() > 0)
+		if(instance->restoredFiberCount.load(std::memory_order_acquire) > 0)
 		{
-			instance->lock_restoredFibersQueue.Acquire();
+			instance->lock_restoredFibers.Acquire();
 
-			if(instance->restoredFibersQueue.size() == 0)
+			if(instance->restoredFibers.Empty())
 			{
-				instance->lock_restoredFibersQueue.Release();
+				instance->lock_restoredFibers.Release();
 				continue;
 			}
 
-			void* restoredFiber = instance->restoredFibersQueue.front();
-			instance->restoredFibersQueue.pop();
-					
-			instance->lock_restoredFibersQueue.Release();
+			TaskFiber* restoredFiber = instance->restoredFibers.Pop();
+			instance->restoredFiberCount.fetch_sub(1, std::memory_order_relaxed);
 
-			assert(restoredFiber);
-			SwitchToFiber(restoredFiber);
+			instance->lock_restoredFibers.Release();
+
+			runningFiber = restoredFiber;
+			Fiber::SwitchTo(restoredFiber->fiber);
+			RegisterPendingWait();
+			ReleaseFinishedFiber();
 			continue;
 		}
 
-		instance->lock_taskQueues.Acquire();
-
-		// Find a task queue to pull from
-		std::queue<FiberEntryParams>* taskQueue = nullptr;
-		if(instance->taskQueues[TaskPriority::LOW].size() > 0)
-			taskQueue = &instance->taskQueues[TaskPriority::LOW];
-		if(instance->taskQueues[TaskPriority::MEDIUM].size() > 0)
-			taskQueue = &instance->taskQueues[TaskPriority::MEDIUM];
-		if(instance->taskQueues[TaskPriority::HIGH].size() > 0)
-			taskQueue = &instance->taskQueues[TaskPriority::HIGH];
-
-		assert(instance->taskQueues[TaskPriority::LOW].empty() || instance->taskQueues[TaskPriority::LOW].front().func);
-
-		instance->lock_taskQueues.Release();
-
 		// If there is a new task available
-		if(taskQueue)
+		FiberEntryParams* task = nullptr;
+		if(TryGetTask(task))
 		{
-			instance->lock_taskQueues.Acquire();
-
-			// After lock is released, make sure queue hasn't been emptied by another thread
-			if(taskQueue->size() == 0)
-			{
-				instance->lock_taskQueues.Release();
-				continue;
-			}
-
-			assert(taskQueue->front().func);
-			FiberEntryParams e = taskQueue->front();
-			FiberEntryParams* task = new FiberEntryParams(e);
-			taskQueue->pop();
-
 			assert(task->func);
 
-			LPVOID taskFiber = CreateFiber(NULL, ExecuteFiber, task);
-			instance->lock_taskQueues.Release();
+			TaskFiber* taskFiber = AcquireFiber();
+			taskFiber->entryParams = task;
 
-			assert(taskFiber);
-			SwitchToFiber(taskFiber);
-			//RunTask(task);
+			runningFiber = taskFiber;
+			Fiber::SwitchTo(taskFiber->fiber);
+			RegisterPendingWait();
+			ReleaseFinishedFiber();
 			continue;
 		}
+
+		std::this_thread::yield();
+	}
+}
+bool Scheduler::TryGetTask(FiberEntryParams*& task)
+{
+	// Highest priority first. Within a priority the worker's own tasks come first, newest first since their data
+	// is most likely still in cache, then tasks queued from outside the workers, then tasks stolen from others.
+	for(int priority = TASK_PRIORITY_COUNT - 1; priority >= 0; priority--)
+	{
+		if(instance->workerQueues[workerIndex]->deques[priority].Pop(task))
+			return true;
+		if(TryPopSharedTask(priority, task))
+			return true;
+		if(TryStealTask(priority, task))
+			return true;
 	}
+	return false;
+}
+bool Scheduler::TryPopSharedTask(int priority, FiberEntryParams*& task)
+{
+	// Skips the lock while nothing is queued from outside, which is nearly always
+	if(instance->sharedTaskCount.load(std::memory_order_acquire) == 0)
+		return false;
+
+	instance->lock_sharedTaskQueues.Acquire();
+	std::queue<FiberEntryParams*>& queue = instance->sharedTaskQueues[priority];
+	bool found = !queue.empty();
+	if(found)
+	{
+		task = queue.front();
+		queue.pop();
+		instance->sharedTaskCount.fetch_sub(1, std::memory_order_relaxed);
+	}
+	instance->lock_sharedTaskQueues.Release();
+	return found;
+}
+bool Scheduler::TryStealTask(int priority, FiberEntryParams*& task)
+{
+	const size_t workerCount = instance->workerQueues.size();
+	if(workerCount < 2)
+		return false;
+
+	// xorshift32, starting at a random victim keeps thieves from all hitting the same worker
+	stealSeed ^= stealSeed << 13;
+	stealSeed ^= stealSeed >> 17;
+	stealSeed ^= stealSeed << 5;
+	const size_t first = stealSeed % workerCount;
+	for(size_t i = 0; i < workerCount; i++)
+	{
+		const size_t victim = (first + i) % workerCount;
+		if(victim != static_cast<size_t>(workerIndex)
+			&& instance->workerQueues[victim]->deques[priority].Steal(task))
+			return true;
+	}
+	return false;
 }
 
-void Scheduler::QueueTask(std::function<void()> task, TaskPriority priority, Counter* taskCounter)
+void Scheduler::QueueTask(Task task, TaskPriority priority, Counter* taskCounter)
 {
 	assert(instance);
 
@@ -155,28 +235,62 @@ void Scheduler::QueueTask(std::function<void()> task, TaskPriority priority, Cou
 	if(taskCounter)
 		taskCounter->Increment();
 
-	FiberEntryParams entryParams = {};
-	entryParams.func = task;
-	entryParams.taskCounter = taskCounter;
+	FiberEntryParams* entryParams = AcquireEntryParams();
+	entryParams->func = std::move(task);
+	entryParams->taskCounter = taskCounter;
 
-	assert(entryParams.func);
+	assert(entryParams->func);
+
+	// Tasks spawned by a worker go to its own deque, where it picks them up without contention
+	if(workerIndex >= 0)
+	{
+		instance->workerQueues[workerIndex]->deques[static_cast<int>(priority)].Push(entryParams);
+		return;
+	}
 
-	// Add the task to the appropriate queue
-	instance->lock_taskQueues.Acquire();
-	instance->taskQueues[priority].push(entryParams);
-	instance->lock_taskQueues.Release();
+	instance->lock_sharedTaskQueues.Acquire();
+	instance->sharedTaskQueues[static_cast<int>(priority)].push(entryParams);
+	instance->sharedTaskCount.fetch_add(1, std::memory_order_release);
+	instance->lock_sharedTaskQueues.Release();
 }
 
 Counter* Scheduler::CreateCounter(int startValue)
 {
 	assert(instance);
 
-	Counter* counter = new Counter(startValue);
+	instance->lock_counters.Acquire();
+	Counter* counter = instance->freeCounters;
+	if(counter)
+	{
+		instance->freeCounters = counter->nextFree;
+		instance->lock_counters.Release();
+		counter->count.store(startValue, std::memory_order_relaxed);
+		return counter;
+	}
+	instance->lock_counters.Release();
+
+	// Only until enough counters for the busiest frame exist, from then on they are all reused
+	counter = new Counter(startValue);
 	instance->lock_counters.Acquire();
 	instance->counters.push_back(counter);
 	instance->lock_counters.Release();
 	return counter;
 }
+void Scheduler::DestroyCounter(Counter* counter)
+{
+	assert(instance);
+	assert(counter->GetCount() == 0 && "Destroying a counter that is still in use.");
+
+	// The decrement that reached zero may still be restoring fibers, it holds the wait list lock until done
+	instance->lock_fiberWaitList.Acquire();
+	assert(counter->waiters.Empty() && "Destroying a counter that fibers are still waiting on.");
+	instance->lock_fiberWaitList.Release();
+
+	instance->lock_counters.Acquire();
+	counter->nextFree = instance->freeCounters;
+	instance->freeCounters = counter;
+	instance->lock_counters.Release();
+}
 void Scheduler::WaitForCounter(Counter* counter)
 {
 	// If counter is already zero, don't wait
@@ -185,169 +299,257 @@ void Scheduler::WaitForCounter(Counter* counter)
 
 	assert(instance);
 
-	// Put current fiber on the wait list
-	void* taskFiber = GetCurrentFiber();
+	// The worker fiber puts this fiber on the wait list once it has switched away from it. Doing it here would
+	// let another thread restore and resume the fiber while it is still running on this one.
+	assert(runningFiber && "Only tasks can wait on a counter.");
+	pendingWaitFiber = runningFiber;
+	pendingWaitCounter = counter;
+
+	// Switch back to local fiber
+	Fiber::SwitchTo(localFiber);
+}
+void Scheduler::RegisterPendingWait()
+{
+	if(!pendingWaitFiber)
+		return;
+
+	TaskFiber* waitingFiber = pendingWaitFiber;
+	Counter* counter = pendingWaitCounter;
+	pendingWaitFiber = nullptr;
+	pendingWaitCounter = nullptr;
+
+	// The counter may have reached zero after the fiber checked it, in which case nothing is left to restore it
 	instance->lock_fiberWaitList.Acquire();
-	if(instance->fiberWaitList.find(counter) != instance->fiberWaitList.end())
+	if(counter->GetCount() == 0)
 	{
-		instance->fiberWaitList[counter].push(taskFiber);
+		instance->lock_restoredFibers.Acquire();
+		instance->restoredFibers.Push(waitingFiber);
+		instance->restoredFiberCount.fetch_add(1, std::memory_order_release);
+		instance->lock_restoredFibers.Release();
 	}
 	else
 	{
-		std::queue<void*> fiberWaitQueue;
-		fiberWaitQueue.push(taskFiber);
-
-		instance->fiberWaitList.emplace(counter, fiberWaitQueue);
+		counter->waiters.Push(waitingFiber);
 	}
 	instance->lock_fiberWaitList.Release();
-
-	// Switch back to local fiber
-	SwitchToFiber(localFiber);
 }
 
 void Scheduler::InitializeFiberPool()
 {
 	lock_fiberPool.Acquire();
-	fiberPool = new TaskFiber[FIBER_POOL_SIZE];
-	for(size_t i = 0; i < FIBER_POOL_SIZE; i++)
+	fiberPool.reserve(fiberPoolSize);
+	for(size_t i = 0; i < fiberPoolSize; i++)
 	{
-		LPVOID newFiber = CreateFiber(NULL, FiberPoolEntryPoint, new size_t(i));
-
-		TaskFiber taskFiber{};
-		taskFiber.fiber = newFiber;
-		taskFiber.entryParams = nullptr;
-		taskFiber.isBusy = false;
-		fiberPool[i] = taskFiber;
+		fiberPool.push_back(std::make_unique<TaskFiber>());
+		TaskFiber* taskFiber = fiberPool.back().get();
+		taskFiber->fiber = Fiber::Create(fiberStackSize, FiberPoolEntryPoint, taskFiber);
+		taskFiber->entryParams = nullptr;
+		taskFiber->next = freeFibers;
+		freeFibers = taskFiber;
 	}
 	lock_fiberPool.Release();
+
+	// Enough params for a full pool's worth of queued tasks before another block is needed
+	lock_entryParams.Acquire();
+	do
+		AddEntryParamsBlock();
+	while(entryParamsBlocks.size() * ENTRY_PARAMS_BLOCK_SIZE < fiberPoolSize);
+	lock_entryParams.Release();
 }
 void Scheduler::DestroyFiberPool()
 {
 	instance->lock_fiberPool.Acquire();
-	for(size_t i = 0; i < FIBER_POOL_SIZE; i++)
-	{
-		DeleteFiber(instance->fiberPool[i].fiber);
-		//delete &instance->fiberPool[i];
-	}
-	instance->fiberPool = nullptr;
+	for(std::unique_ptr<TaskFiber>& taskFiber : instance->fiberPool)
+		Fiber::Destroy(taskFiber->fiber);
+	instance->fiberPool.clear();
+	instance->freeFibers = nullptr;
 	instance->lock_fiberPool.Release();
+
+	instance->lock_entryParams.Acquire();
+	instance->entryParamsBlocks.clear();
+	instance->freeEntryParams = nullptr;
+	instance->lock_entryParams.Release();
+
+	instance->workerFreeLists.clear();
 }
 
-void Scheduler::RunTask(FiberEntryParams* entryParams)
+TaskFiber* Scheduler::AcquireFiber()
 {
-	TaskFiber* taskFiber = GetFirstAvailableFiberInPool();
+	// Only the worker loop starts tasks, so there always is a local list
+	WorkerFreeLists& local = *instance->workerFreeLists[workerIndex];
+	if(!local.fibers)
+	{
+		instance->lock_fiberPool.Acquire();
+		local.fiberCount = MoveFreeNodes(instance->freeFibers, local.fibers, FREE_LIST_BATCH_SIZE);
+		instance->lock_fiberPool.Release();
+	}
+
+	TaskFiber* taskFiber = local.fibers;
 	if(taskFiber)
 	{
-		taskFiber->entryParams = entryParams;
-		SwitchToFiber(taskFiber->fiber);
+		local.fibers = taskFiber->next;
+		local.fiberCount--;
+		return taskFiber;
+	}
 
+	// Every fiber is running or waiting on a counter, add one more. Created outside the lock so other workers
+	// can keep returning and taking fibers meanwhile.
+	std::unique_ptr<TaskFiber> newFiber = std::make_unique<TaskFiber>();
+	taskFiber = newFiber.get();
+	taskFiber->fiber = Fiber::Create(instance->fiberStackSize, FiberPoolEntryPoint, taskFiber);
+	taskFiber->entryParams = nullptr;
+	taskFiber->next = nullptr;
+
+	instance->lock_fiberPool.Acquire();
+	instance->fiberPool.push_back(std::move(newFiber));
+	instance->lock_fiberPool.Release();
+	return taskFiber;
+}
+void Scheduler::ReleaseFinishedFiber()
+{
+	if(!finishedFiber)
+		return;
+
+	TaskFiber* taskFiber = finishedFiber;
+	finishedFiber = nullptr;
+	ReleaseFiber(taskFiber);
+}
+void Scheduler::ReleaseFiber(TaskFiber* taskFiber)
+{
+	WorkerFreeLists& local = *instance->workerFreeLists[workerIndex];
+	taskFiber->next = local.fibers;
+	local.fibers = taskFiber;
+	local.fiberCount++;
+
+	// Fibers that started on one worker and finished on another pile up there, hand a batch back for the others
+	if(local.fiberCount >= 2 * FREE_LIST_BATCH_SIZE)
+	{
 		instance->lock_fiberPool.Acquire();
-		taskFiber->isBusy = false;
+		local.fiberCount -= MoveFreeNodes(local.fibers, instance->freeFibers, FREE_LIST_BATCH_SIZE);
 		instance->lock_fiberPool.Release();
 	}
-	else
+}
+FiberEntryParams* Scheduler::AcquireEntryParams()
+{
+	// Threads that are not workers, e.g. queueing before Run(), take from the shared list directly
+	if(workerIndex < 0)
+	{
+		instance->lock_entryParams.Acquire();
+		// Rare enough that allocating under the lock is fine
+		if(!instance->freeEntryParams)
+			instance->AddEntryParamsBlock();
+
+		FiberEntryParams* entryParams = instance->freeEntryParams;
+		instance->freeEntryParams = entryParams->next;
+		instance->lock_entryParams.Release();
+		return entryParams;
+	}
+
+	WorkerFreeLists& local = *instance->workerFreeLists[workerIndex];
+	if(!local.entryParams)
+	{
+		instance->lock_entryParams.Acquire();
+		if(!instance->freeEntryParams)
+			instance->AddEntryParamsBlock();
+		local.entryParamsCount = MoveFreeNodes(instance->freeEntryParams, local.entryParams, FREE_LIST_BATCH_SIZE);
+		instance->lock_entryParams.Release();
+	}
+
+	FiberEntryParams* entryParams = local.entryParams;
+	local.entryParams = entryParams->next;
+	local.entryParamsCount--;
+	return entryParams;
+}
+void Scheduler::AddEntryParamsBlock()
+{
+	entryParamsBlocks.push_back(std::make_unique<FiberEntryParams[]>(ENTRY_PARAMS_BLOCK_SIZE));
+	FiberEntryParams* block = entryParamsBlocks.back().get();
+	for(size_t i = 0; i < ENTRY_PARAMS_BLOCK_SIZE; i++)
+		block[i].next = i + 1 < ENTRY_PARAMS_BLOCK_SIZE ? &block[i + 1] : freeEntryParams;
+	freeEntryParams = block;
+}
+void Scheduler::ReleaseEntryParams(FiberEntryParams* entryParams)
+{
+	// Tasks only run on workers
+	WorkerFreeLists& local = *instance->workerFreeLists[workerIndex];
+	entryParams->next = local.entryParams;
+	local.entryParams = entryParams;
+	local.entryParamsCount++;
+
+	// Params of tasks queued by one worker and run by another pile up on the one running them
+	if(local.entryParamsCount >= 2 * FREE_LIST_BATCH_SIZE)
 	{
-		// Fallback: create and destroy a temporary fiber if pool is exhausted
-		LPVOID tempFiber = CreateFiber(NULL, ExecuteFiber, entryParams);
-		SwitchToFiber(tempFiber);
-		DeleteFiber(tempFiber);
+		instance->lock_entryParams.Acquire();
+		local.entryParamsCount -= MoveFreeNodes(local.entryParams, instance->freeEntryParams, FREE_LIST_BATCH_SIZE);
+		instance->lock_entryParams.Release();
 	}
 }
 
-void Scheduler::FiberPoolEntryPoint(void* poolIndex)
+void Scheduler::FiberPoolEntryPoint(void* taskFiber)
 {
 	assert(instance);
 
-	// These values should be constant throughout the fiberpool's lifetime
-	const size_t index = *((size_t*) poolIndex);
-	TaskFiber* poolFiber = &instance->fiberPool[index];
-
-	// Don't need the index pointer anymore
-	delete poolIndex;
+	TaskFiber* poolFiber = (TaskFiber*) taskFiber;
 
 	// Per-task logic that can be reused for any tasks run on this pool fiber
 	while(true)
 	{
-		poolFiber->isBusy = true;
-
-		// Param values should be set before switching to this fiber so we can read the new values here
-
-		std::function<void()> func = poolFiber->entryParams->func;
-		Counter* taskCounter = poolFiber->entryParams->taskCounter;
-
-		// The entry params are now old
-		delete poolFiber->entryParams;
+		// Param values are set before switching to this fiber so we can read the new values here
+		FiberEntryParams* entryParams = poolFiber->entryParams;
 		poolFiber->entryParams = nullptr;
+		Counter* taskCounter = entryParams->taskCounter;
 
-		assert(func);
-		func();
+		{
+			// Moved out so the params can be reused while the task runs, and so the task's captures are
+			// destroyed before its counter is decremented
+			Task func = std::move(entryParams->func);
+			ReleaseEntryParams(entryParams);
+
+			assert(func);
+			func();
+		}
 
 		// After execution of the task completes, decrement the associated task counter if applicable
 		if(taskCounter)
 			taskCounter->Decrement();
 
-		// Task is complete - switch back to worker fiber
-		// Task fiber is marked as reusable after switching back
-		SwitchToFiber(localFiber);
+		// Task is complete - switch back to worker fiber, which puts this fiber back on the free list
+		finishedFiber = poolFiber;
+		Fiber::SwitchTo(localFiber);
 	}
 }
-void Scheduler::ExecuteFiber(void* fiberEntryParams)
-{
-	FiberEntryParams* entryParams = (FiberEntryParams*) fiberEntryParams;
-
-	// Save the param values locally to avoid pointer misdirection during fiber execution
-
-	std::function<void()> func = entryParams->func;
-	Counter* taskCounter = entryParams->taskCounter;
-
-	delete entryParams;
-
-	assert(func);
-	func();
-
-	// After execution of the task completes, decrement the associated task counter if applicable
-	if(taskCounter)
-		taskCounter->Decrement();
-
-	// Task is complete - switch back to worker fiber
-	SwitchToFiber(localFiber);
-}
 
 void Scheduler::RestoreFibersFromWaitList(Counter* counter)
 {
 	assert(instance);
 
-	instance->lock_restoredFibersQueue.Acquire();
-
 	instance->lock_fiberWaitList.Acquire();
-	std::queue<void*>& fiberWaitQueue = instance->fiberWaitList[counter];
-	instance->lock_fiberWaitList.Release();
-
-	for(int i = 0; i < fiberWaitQueue.size(); i++)
+	if(!counter->waiters.Empty())
 	{
-		auto waitingFiber = fiberWaitQueue.front();
-		assert(waitingFiber);
-		instance->restoredFibersQueue.push(waitingFiber);
-		fiberWaitQueue.pop();
+		instance->lock_restoredFibers.Acquire();
+		const int restoredCount = counter->waiters.size;
+		instance->restoredFibers.Splice(counter->waiters);
+		instance->restoredFiberCount.fetch_add(restoredCount, std::memory_order_release);
+		instance->lock_restoredFibers.Release();
 	}
-	instance->lock_restoredFibersQueue.Release();
+	instance->lock_fiberWaitList.Release();
 }
-
-TaskFiber* Scheduler::GetFirstAvailableFiberInPool()
+void Scheduler::DecrementAndRestore(Counter* counter)
 {
-	instance->lock_fiberPool.Acquire();
-    for(size_t i = 0; i < FIBER_POOL_SIZE; i++)
-    {
-		TaskFiber* fiber = &instance->fiberPool[i];
-        if(!fiber->isBusy)
-        {
-			instance->lock_fiberPool.Release();
-            
-			return fiber;
-        }
-    }
-	instance->lock_fiberPool.Release();
+	assert(instance);
 
-    // Expand the pool if needed?
-    return nullptr;
-}
\ No newline at end of file
+	// Holding the wait list lock across the decrement keeps a waiter that sees zero from destroying the counter
+	// before its waiting fibers have been restored
+	instance->lock_fiberWaitList.Acquire();
+	int oldValue = counter->count.fetch_sub(1, std::memory_order_acq_rel);
+	if(oldValue - 1 == 0 && !counter->waiters.Empty())
+	{
+		// Moved straight over, same lock order as RegisterPendingWait()
+		instance->lock_restoredFibers.Acquire();
+		const int restoredCount = counter->waiters.size;
+		instance->restoredFibers.Splice(counter->waiters);
+		instance->restoredFiberCount.fetch_add(restoredCount, std::memory_order_release);
+		instance->lock_restoredFibers.Release();
+	}
+	instance->lock_fiberWaitList.Release();
+}
@@ -1,15 +1,18 @@
 #pragma once
 
-#include <functional>
+#include <atomic>
+#include <memory>
 #include <queue>
 #include <thread>
 #include <mutex>
-#include <map>
 
 #include "Counter.h"
+#include "Fiber.h"
 #include "SpinLock.h"
-
-#include "Windows.h"
+#include "Task.h"
+#include "TaskBlockPool.h"
+#include "TaskFiber.h"
+#include "WorkStealingDeque.h"
 
 #define QUEUE_TASK(functionBody) \
     QueueTask([&]()                \
@@ -23,48 +26,87 @@ enum class TaskPriority
     MEDIUM,
     HIGH
 };
+static const int TASK_PRIORITY_COUNT = 3;
 
 struct FiberEntryParams
 {
-    std::function<void()> func;
+    Task func;
     Counter* taskCounter;
+    // Next unused params while on a free list
+    FiberEntryParams* next;
+};
+// One deque per priority for every worker thread, tasks queued by a worker go to its own deques
+struct WorkerQueues
+{
+	WorkStealingDeque<FiberEntryParams*> deques[TASK_PRIORITY_COUNT];
 };
-struct TaskFiber
+
+// Idle fibers and entry params kept by one worker, only ever touched by its own thread
+struct alignas(64) WorkerFreeLists
 {
-    LPVOID fiber;
-    FiberEntryParams* entryParams;
-    bool isBusy;
+	TaskFiber* fibers = nullptr;
+	size_t fiberCount = 0;
+	FiberEntryParams* entryParams = nullptr;
+	size_t entryParamsCount = 0;
 };
 
 class Scheduler
 {
+public:
+    static const size_t DEFAULT_FIBER_POOL_SIZE = 128;
+
 private:
-    static const size_t FIBER_POOL_SIZE = 100;
+    // Entry params are allocated in blocks of this many when the free list runs out
+    static const size_t ENTRY_PARAMS_BLOCK_SIZE = 256;
+    // Fibers and entry params move between a worker's free lists and the shared ones this many at a time, a
+    // worker holding twice as many hands a batch back
+    static const size_t FREE_LIST_BATCH_SIZE = 32;
 
 private:
     std::vector<std::thread> threads;
     void* primaryFiber;
 
-    TaskFiber* fiberPool;
+    // Every task fiber and every block of entry params, owned here and reused through the free lists. Workers
+    // take from and return to their own lists and only go to the shared ones below in batches.
+    const size_t fiberPoolSize;
+    const size_t fiberStackSize;
+    std::vector<std::unique_ptr<TaskFiber>> fiberPool;
+    TaskFiber* freeFibers;
 	SpinLock lock_fiberPool;
 
-    std::map<TaskPriority, std::queue<FiberEntryParams>> taskQueues;
-    SpinLock lock_taskQueues;
+    std::vector<std::unique_ptr<FiberEntryParams[]>> entryParamsBlocks;
+    FiberEntryParams* freeEntryParams;
+	SpinLock lock_entryParams;
 
-	// All counters created and used by any task
+	std::vector<std::unique_ptr<WorkerFreeLists>> workerFreeLists;
+
+	std::vector<std::unique_ptr<WorkerQueues>> workerQueues;
+	// Storage for captures too large to fit inside a task, one pool per worker
+	std::vector<std::unique_ptr<TaskBlockPool>> taskBlockPools;
+
+	// Tasks queued from threads that are not workers, e.g. before Run()
+	std::queue<FiberEntryParams*> sharedTaskQueues[TASK_PRIORITY_COUNT];
+	std::atomic<int> sharedTaskCount{0};
+	SpinLock lock_sharedTaskQueues;
+
+	// Every counter ever created, destroyed ones are reused through the free list
     std::vector<Counter*> counters;
+    Counter* freeCounters;
 	SpinLock lock_counters;
 
-    std::queue<void*> restoredFibersQueue;
-    SpinLock lock_restoredFibersQueue;
+    TaskFiberList restoredFibers;
+	// Length of restoredFibers, lets workers check for restored fibers without taking the lock
+	std::atomic<int> restoredFiberCount{0};
+    SpinLock lock_restoredFibers;
 
-    std::map<Counter*, std::queue<void*>> fiberWaitList;
+    // Guards the waiters of every counter
     SpinLock lock_fiberWaitList;
 
-	bool shouldTerminate = false;
+	std::atomic<bool> shouldTerminate{false};
 
 public:
-    Scheduler();
+    // Starts out with fiberPoolSize task fibers, more are created whenever all of them are running or waiting
+    explicit Scheduler(size_t fiberPoolSize = DEFAULT_FIBER_POOL_SIZE, size_t fiberStackSize = Fiber::DEFAULT_STACK_SIZE);
     ~Scheduler();
 
     void Startup();
@@ -73,9 +115,11 @@ public:
     void Run();
     static void ExecuteWorkerThread();
 
-    static void QueueTask(std::function<void()> task, TaskPriority priority = TaskPriority::LOW, Counter* taskCounter = nullptr);
+    static void QueueTask(Task task, TaskPriority priority = TaskPriority::LOW, Counter* taskCounter = nullptr);
 
 	static Counter* CreateCounter(int startValue = 0);
+	// Hands a counter back for reuse once no task or waiting fiber refers to it anymore
+	static void DestroyCounter(Counter* counter);
     static void WaitForCounter(Counter* counter);
 
 private:
@@ -83,14 +127,23 @@ private:
     void InitializeFiberPool();
     static void DestroyFiberPool();
 
-    static void RunTask(FiberEntryParams* entryParams);
+    static TaskFiber* AcquireFiber();
+    static void ReleaseFinishedFiber();
+    static void ReleaseFiber(TaskFiber* taskFiber);
+    static FiberEntryParams* AcquireEntryParams();
+    // Caller holds lock_entryParams
+    void AddEntryParamsBlock();
+    static void ReleaseEntryParams(FiberEntryParams* entryParams);
 
-    static void FiberPoolEntryPoint(void* poolIndex);
-    static void ExecuteFiber(void* fiberEntryParams);
+	static bool TryGetTask(FiberEntryParams*& task);
+	static bool TryPopSharedTask(int priority, FiberEntryParams*& task);
+	static bool TryStealTask(int priority, FiberEntryParams*& task);
 
-    static void RestoreFibersFromWaitList(Counter* counter);
+    static void FiberPoolEntryPoint(void* taskFiber);
 
-    static TaskFiber* GetFirstAvailableFiberInPool();
+    static void RestoreFibersFromWaitList(Counter* counter);
+	static void DecrementAndRestore(Counter* counter);
+	static void RegisterPendingWait();
 
     // Counter increment and decrement access RestoreFibersFromWaitList() to notify when counter has reached desired value
     friend void Counter::Increment();
@@ -1,5 +1,7 @@
 #include "SpinLock.h"
 
+#include <thread>
+
 SpinLock::SpinLock()
 {
 
@@ -1,11 +1,12 @@
 #pragma once
 
+#include <atomic>
 #include <mutex>
 
 class SpinLock
 {
 private:
-	std::atomic_flag locked;
+	std::atomic_flag locked = ATOMIC_FLAG_INIT;
 
 public:
 	SpinLock();
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "TaskBlockPool.h"
+
+// Move-only callable queued with Scheduler::QueueTask(), one cache line in size. Captures up to INLINE_CAPACITY
+// bytes are stored inside the task; larger ones go in a block from the queuing worker's TaskBlockPool. Unlike
+// std::function a task is never copied on its way through the queues, so captures only need to be movable.
+class Task
+{
+public:
+	static const size_t SIZE = 64;
+	static const size_t INLINE_CAPACITY = SIZE - sizeof(void*);
+
+private:
+	struct Operations
+	{
+		void (*invoke)(void* storage);
+		// Move constructs into to and destroys from
+		void (*relocate)(void* from, void* to);
+		void (*destroy)(void* storage);
+	};
+
+	template<typename F>
+	static constexpr bool IS_INLINE = sizeof(F) <= INLINE_CAPACITY && alignof(F) <= alignof(std::max_align_t)
+		&& std::is_nothrow_move_constructible<F>::value;
+
+	// Captures stored in place
+	template<typename F>
+	struct InlineOperations
+	{
+		static void Invoke(void* storage) { (*static_cast<F*>(storage))(); }
+		static void Relocate(void* from, void* to)
+		{
+			new(to) F(std::move(*static_cast<F*>(from)));
+			static_cast<F*>(from)->~F();
+		}
+		static void Destroy(void* storage) { static_cast<F*>(storage)->~F(); }
+
+		static constexpr Operations OPERATIONS{Invoke, Relocate, Destroy};
+	};
+
+	// Storage holds a pointer to the captures
+	template<typename F>
+	struct PooledOperations
+	{
+		static F*& Get(void* storage) { return *static_cast<F**>(storage); }
+
+		static void Invoke(void* storage) { (*Get(storage))(); }
+		static void Relocate(void* from, void* to) { new(to) F*(Get(from)); }
+		static void Destroy(void* storage)
+		{
+			Get(storage)->~F();
+			TaskBlockPool::Free(Get(storage));
+		}
+
+		static constexpr Operations OPERATIONS{Invoke, Relocate, Destroy};
+	};
+
+	alignas(std::max_align_t) unsigned char storage[INLINE_CAPACITY];
+	const Operations* operations = nullptr;
+
+public:
+	Task() = default;
+
+	template<typename F, typename = std::enable_if_t<!std::is_same<std::decay_t<F>, Task>::value>>
+	Task(F&& func)
+	{
+		using Callable = std::decay_t<F>;
+		static_assert(alignof(Callable) <= alignof(std::max_align_t), "Over-aligned task captures are not supported.");
+
+		if constexpr(IS_INLINE<Callable>)
+		{
+			new(storage) Callable(std::forward<F>(func));
+			operations = &InlineOperations<Callable>::OPERATIONS;
+		}
+		else
+		{
+			void* memory = TaskBlockPool::Allocate(sizeof(Callable));
+			new(storage) Callable*(new(memory) Callable(std::forward<F>(func)));
+			operations = &PooledOperations<Callable>::OPERATIONS;
+		}
+	}
+
+	Task(Task&& other) noexcept
+	{
+		MoveFrom(other);
+	}
+	Task& operator=(Task&& other) noexcept
+	{
+		if(this != &other)
+		{
+			Reset();
+			MoveFrom(other);
+		}
+		return *this;
+	}
+
+	Task(const Task&) = delete;
+	Task& operator=(const Task&) = delete;
+
+	~Task()
+	{
+		Reset();
+	}
+
+	void operator()()
+	{
+		assert(operations && "Running an empty task.");
+		operations->invoke(storage);
+	}
+
+	explicit operator bool() const { return operations != nullptr; }
+
+	// Destroys the captures, leaving the task empty
+	void Reset()
+	{
+		if(operations)
+		{
+			operations->destroy(storage);
+			operations = nullptr;
+		}
+	}
+
+private:
+	void MoveFrom(Task& other)
+	{
+		if(other.operations)
+		{
+			other.operations->relocate(other.storage, storage);
+			operations = other.operations;
+			other.operations = nullptr;
+		}
+	}
+};
+
+static_assert(sizeof(Task) == Task::SIZE, "A task should fill exactly one cache line.");
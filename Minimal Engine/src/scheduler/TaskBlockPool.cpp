@@ -0,0 +1,92 @@
+#include "TaskBlockPool.h"
+
+#include <cassert>
+
+// Pool of the local thread, nullptr on threads that are not workers
+thread_local TaskBlockPool* currentPool;
+
+// Captures start after the block header, padded so they keep the alignment of new
+static const size_t HEADER_SIZE = (sizeof(void*) * 2 + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) * alignof(std::max_align_t);
+
+TaskBlockPool::TaskBlockPool() :
+	freeBlocks(nullptr),
+	remoteFreeBlocks(nullptr)
+{
+
+}
+TaskBlockPool::~TaskBlockPool()
+{
+	if(currentPool == this)
+		currentPool = nullptr;
+}
+
+void TaskBlockPool::SetCurrent(TaskBlockPool* pool)
+{
+	currentPool = pool;
+}
+
+void* TaskBlockPool::Allocate(size_t size)
+{
+	Block* block = nullptr;
+	if(currentPool && HEADER_SIZE + size <= BLOCK_SIZE)
+	{
+		block = currentPool->Pop();
+		block->owner = currentPool;
+	}
+	else
+	{
+		block = reinterpret_cast<Block*>(new char[HEADER_SIZE + size]);
+		block->owner = nullptr;
+	}
+	return reinterpret_cast<char*>(block) + HEADER_SIZE;
+}
+void TaskBlockPool::Free(void* memory)
+{
+	Block* block = reinterpret_cast<Block*>(static_cast<char*>(memory) - HEADER_SIZE);
+	TaskBlockPool* owner = block->owner;
+
+	if(!owner)
+	{
+		delete[] reinterpret_cast<char*>(block);
+		return;
+	}
+
+	if(owner == currentPool)
+	{
+		block->next = owner->freeBlocks;
+		owner->freeBlocks = block;
+		return;
+	}
+
+	// Only the owner ever takes from the remote list, and always all of it at once, so pushes don't suffer from ABA
+	block->next = owner->remoteFreeBlocks.load(std::memory_order_relaxed);
+	while(!owner->remoteFreeBlocks.compare_exchange_weak(block->next, block, std::memory_order_release, std::memory_order_relaxed))
+	{
+
+	}
+}
+
+TaskBlockPool::Block* TaskBlockPool::Pop()
+{
+	if(!freeBlocks)
+		freeBlocks = remoteFreeBlocks.exchange(nullptr, std::memory_order_acquire);
+	if(!freeBlocks)
+		AddChunk();
+
+	Block* block = freeBlocks;
+	freeBlocks = block->next;
+	return block;
+}
+void TaskBlockPool::AddChunk()
+{
+	static_assert(BLOCK_SIZE % alignof(std::max_align_t) == 0, "Blocks must keep the alignment of new.");
+
+	chunks.push_back(std::make_unique<char[]>(BLOCK_SIZE * BLOCKS_PER_CHUNK));
+	char* chunk = chunks.back().get();
+	for(size_t i = 0; i < BLOCKS_PER_CHUNK; i++)
+	{
+		Block* block = reinterpret_cast<Block*>(chunk + i * BLOCK_SIZE);
+		block->next = freeBlocks;
+		freeBlocks = block;
+	}
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Fixed-size blocks for task captures that do not fit inside a Task. Each worker owns a pool and allocates from it
+// without locking. A block freed on another thread goes onto its owner's remote list with a compare-and-swap; the
+// owner takes that whole list back once its own list runs dry. That way tasks queued on one worker and run on
+// another don't leave every block stranded on the thread that ran them.
+class TaskBlockPool
+{
+public:
+	static const size_t BLOCK_SIZE = 256;
+	static const size_t BLOCKS_PER_CHUNK = 64;
+
+private:
+	struct Block
+	{
+		// Pool the block came from, nullptr for oversized captures allocated with new
+		TaskBlockPool* owner;
+		Block* next;
+	};
+
+	// Owner only
+	Block* freeBlocks;
+	std::vector<std::unique_ptr<char[]>> chunks;
+
+	// Blocks freed by other threads
+	std::atomic<Block*> remoteFreeBlocks;
+
+public:
+	TaskBlockPool();
+	~TaskBlockPool();
+
+	TaskBlockPool(const TaskBlockPool&) = delete;
+	TaskBlockPool& operator=(const TaskBlockPool&) = delete;
+
+	// Makes pool the one Allocate() uses on the calling thread, nullptr for none
+	static void SetCurrent(TaskBlockPool* pool);
+
+	// Storage for size bytes aligned like std::max_align_t. Comes from the calling thread's pool when it has one
+	// and the size fits a block, from new otherwise.
+	static void* Allocate(size_t size);
+	// Any thread
+	static void Free(void* memory);
+
+private:
+	Block* Pop();
+	void AddChunk();
+};
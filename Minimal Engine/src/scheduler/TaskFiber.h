@@ -0,0 +1,57 @@
+#pragma once
+
+struct FiberEntryParams;
+
+// Pooled fiber that runs one task after another
+struct TaskFiber
+{
+    void* fiber;
+    // Task to run, set before switching to the fiber
+    FiberEntryParams* entryParams;
+    // Next fiber on the list holding this one, a fiber is only ever free, waiting on a counter or restored
+    TaskFiber* next;
+};
+
+// First-in first-out list of task fibers linked through TaskFiber::next, never allocates
+struct TaskFiberList
+{
+	TaskFiber* head = nullptr;
+	TaskFiber* tail = nullptr;
+	int size = 0;
+
+	bool Empty() const { return head == nullptr; }
+
+	void Push(TaskFiber* taskFiber)
+	{
+		taskFiber->next = nullptr;
+		if(tail)
+			tail->next = taskFiber;
+		else
+			head = taskFiber;
+		tail = taskFiber;
+		size++;
+	}
+	TaskFiber* Pop()
+	{
+		TaskFiber* taskFiber = head;
+		head = taskFiber->next;
+		if(!head)
+			tail = nullptr;
+		size--;
+		return taskFiber;
+	}
+	// Moves every fiber of other to the end of this list
+	void Splice(TaskFiberList& other)
+	{
+		if(other.Empty())
+			return;
+
+		if(tail)
+			tail->next = other.head;
+		else
+			head = other.head;
+		tail = other.tail;
+		size += other.size;
+		other = TaskFiberList();
+	}
+};
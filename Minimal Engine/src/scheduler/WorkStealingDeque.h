@@ -0,0 +1,134 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+// Chase-Lev work-stealing deque. The owning thread pushes and pops at the bottom without locking, any other thread
+// steals from the top with a single compare-and-swap. The buffer doubles when full; replaced buffers are kept until
+// the deque is destroyed because a thief may still be reading from one.
+// Memory orders follow Le et al., "Correct and Efficient Work-Stealing for Weak Memory Models".
+template<typename T>
+class WorkStealingDeque
+{
+	static_assert(std::is_trivially_copyable<T>::value, "Thieves read elements that the owner may overwrite.");
+
+private:
+	struct Buffer
+	{
+		explicit Buffer(int64_t capacity) :
+			mask(capacity - 1),
+			elements(new std::atomic<T>[capacity])
+		{
+
+		}
+
+		int64_t Capacity() const { return mask + 1; }
+
+		T Get(int64_t index) const { return elements[index & mask].load(std::memory_order_relaxed); }
+		void Put(int64_t index, T value) { elements[index & mask].store(value, std::memory_order_relaxed); }
+
+		int64_t mask;
+		std::unique_ptr<std::atomic<T>[]> elements;
+	};
+
+	// Thieves contend on top while the owner works on bottom, so each gets its own cache line
+	alignas(64) std::atomic<int64_t> top;
+	alignas(64) std::atomic<int64_t> bottom;
+	std::atomic<Buffer*> buffer;
+
+	// Every buffer ever used, only touched by the owner
+	std::vector<std::unique_ptr<Buffer>> buffers;
+
+public:
+	// Capacity must be a power of two
+	explicit WorkStealingDeque(int64_t capacity = 256) :
+		top(0),
+		bottom(0)
+	{
+		buffers.push_back(std::make_unique<Buffer>(capacity));
+		buffer.store(buffers.back().get(), std::memory_order_relaxed);
+	}
+
+	WorkStealingDeque(const WorkStealingDeque&) = delete;
+	WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+	// Owner only
+	void Push(T value)
+	{
+		int64_t b = bottom.load(std::memory_order_relaxed);
+		int64_t t = top.load(std::memory_order_acquire);
+		Buffer* a = buffer.load(std::memory_order_relaxed);
+		if(b - t > a->Capacity() - 1)
+			a = Grow(a, t, b);
+
+		a->Put(b, value);
+		std::atomic_thread_fence(std::memory_order_release);
+		bottom.store(b + 1, std::memory_order_relaxed);
+	}
+
+	// Owner only, takes the most recently pushed element
+	bool Pop(T& out)
+	{
+		int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+		Buffer* a = buffer.load(std::memory_order_relaxed);
+		bottom.store(b, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t t = top.load(std::memory_order_relaxed);
+
+		if(t > b)
+		{
+			// Empty
+			bottom.store(b + 1, std::memory_order_relaxed);
+			return false;
+		}
+
+		out = a->Get(b);
+		if(t == b)
+		{
+			// Last element, race the thieves for it
+			bool won = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+			bottom.store(b + 1, std::memory_order_relaxed);
+			return won;
+		}
+		return true;
+	}
+
+	// Any thread, takes the oldest element. Fails when empty or when another thread took it first.
+	bool Steal(T& out)
+	{
+		int64_t t = top.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t b = bottom.load(std::memory_order_acquire);
+		if(t >= b)
+			return false;
+
+		Buffer* a = buffer.load(std::memory_order_acquire);
+		T value = a->Get(t);
+		if(!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			return false;
+
+		out = value;
+		return true;
+	}
+
+	// Approximate when called concurrently with other operations
+	bool IsEmpty() const
+	{
+		return bottom.load(std::memory_order_relaxed) <= top.load(std::memory_order_relaxed);
+	}
+
+private:
+	Buffer* Grow(Buffer* old, int64_t t, int64_t b)
+	{
+		buffers.push_back(std::make_unique<Buffer>(old->Capacity() * 2));
+		Buffer* grown = buffers.back().get();
+		for(int64_t i = t; i < b; i++)
+			grown->Put(i, old->Get(i));
+
+		buffer.store(grown, std::memory_order_release);
+		return grown;
+	}
+};
@@ -5,7 +5,9 @@
 #include "CameraSystem.hpp"
 
 namespace Minimal {
-    CameraSystem::CameraSystem(ECSCoordinator &ecs): System(ecs) {}
+    CameraSystem::CameraSystem(ECSCoordinator &ecs): System(ecs), m_cameras(ecs) {
+        m_access.read<TransformComponent>().write<CameraComponent>();
+    }
 
     void CameraSystem::setOrthographicProjection(Entity cameraEntity, float left, float right, float top, float bottom, float near, float far) {
         if (hasCamera(cameraEntity))
@@ -50,7 +52,7 @@ namespace Minimal {
             return;
 
         auto &camera = getCamera(cameraEntity);
-        auto &transform = m_ecs.getComponent<TransformComponent>(cameraEntity);
+        auto &transform = m_ecs.getComponent<const TransformComponent>(cameraEntity);
 
         const glm::vec3 w{normalize(direction)};
         const glm::vec3 u{normalize(cross(w, up))};
@@ -89,7 +91,7 @@ namespace Minimal {
         if (hasCamera(cameraEntity))
             return;
 
-        auto &transform = m_ecs.getComponent<TransformComponent>(cameraEntity);
+        auto &transform = m_ecs.getComponent<const TransformComponent>(cameraEntity);
 
         setViewDirection(cameraEntity, target - transform.position, up);
     }
@@ -99,11 +101,11 @@ namespace Minimal {
             return;
 
         auto &camera = getCamera(cameraEntity);
-        auto &transform = m_ecs.getComponent<TransformComponent>(cameraEntity);
+        auto &transform = m_ecs.getComponent<const TransformComponent>(cameraEntity);
         setViewYXZ(camera, transform);
     }
 
-    void CameraSystem::setViewYXZ(CameraComponent &camera, TransformComponent &transform) {
+    void CameraSystem::setViewYXZ(CameraComponent &camera, const TransformComponent &transform) {
         const float c3 = glm::cos(glm::roll(transform.rotation));
         const float s3 = glm::sin(glm::roll(transform.rotation));
         const float c2 = glm::cos(glm::pitch(transform.rotation));
@@ -143,22 +145,22 @@ namespace Minimal {
         camera.inverseViewMatrix[3][2] = transform.position.z;
     }
 
-    CameraComponent &CameraSystem::getMainCamera() {
-        CameraComponent *fallBackCamera{nullptr};
-        for (Entity entity = 0; entity < m_ecs.getEntityCount(); entity++) {
-            if (!hasCamera(entity))
-                continue;
-
-            auto &camera = getCamera(entity);
+    const CameraComponent &CameraSystem::getMainCamera() {
+        // Read-only, so looking for the main camera does not stamp every camera as changed
+        const CameraComponent *fallBackCamera{nullptr};
+        Entity fallBackEntity{INVALID_ENTITY};
+        for (auto [entity, camera] : m_ecs.view<const CameraComponent>()) {
             if (camera.isMain)
                 return camera;
 
-            if (fallBackCamera == nullptr)
+            if (fallBackCamera == nullptr) {
                 fallBackCamera = &camera;
+                fallBackEntity = entity;
+            }
         }
 
         if (fallBackCamera != nullptr)
-            fallBackCamera->isMain = true;
+            m_ecs.getComponent<CameraComponent>(fallBackEntity).isMain = true;
 
         return *fallBackCamera;
     }
@@ -167,12 +169,7 @@ namespace Minimal {
         CameraComponent *mainCamera{nullptr};
         CameraComponent *fallbackCamera{nullptr};
 
-        for (Entity entity = 0; entity < m_ecs.getEntityCount(); entity++) {
-            if (!hasCamera(entity))
-                continue;
-
-            auto &camera = getCamera(entity);
-            auto &cameraTransform = m_ecs.getComponent<TransformComponent>(entity);
+        for (auto [entity, camera, cameraTransform] : m_cameras.view()) {
             setViewYXZ(camera, cameraTransform);
 
             // setOthrographicProjection(-frameInfo.aspect, frameInfo.aspect, -1.0f, 1.0f, -1.0f, 1.0f);
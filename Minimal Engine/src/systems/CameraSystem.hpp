@@ -28,9 +28,9 @@ namespace Minimal {
 
         void setViewYXZ(Entity cameraEntity);
 
-        void setViewYXZ(CameraComponent &camera, TransformComponent &transform);
+        void setViewYXZ(CameraComponent &camera, const TransformComponent &transform);
 
-        CameraComponent &getMainCamera();
+        const CameraComponent &getMainCamera();
 
         void update(FrameInfo &frameInfo);
 
@@ -38,5 +38,7 @@ namespace Minimal {
         bool hasCamera(Entity cameraEntity);
 
         CameraComponent &getCamera(Entity cameraEntity);
+
+        Query<CameraComponent, const TransformComponent> m_cameras;
     };
 }
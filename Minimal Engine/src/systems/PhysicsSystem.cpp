@@ -7,17 +7,14 @@
 
 namespace Minimal
 {
-	PhysicsSystem::PhysicsSystem(ECSCoordinator& ecs) : System(ecs) {}
-	
-	void PhysicsSystem::initialize() {
-		counter = Scheduler::CreateCounter();
+	PhysicsSystem::PhysicsSystem(ECSCoordinator& ecs) : System(ecs), integrationBodies(ecs), collisionBodies(ecs)
+	{
+		m_access.read<ColliderComponent, RigidbodyPropertiesComponent>().write<TransformComponent, RigidbodyComponent>();
 	}
-
+	
 	void PhysicsSystem::update(FrameInfo& frameInfo) {
 		static const float PHYSICS_TICK = 0.01f;
 
-		static float simulationTimeLeft = 0;
-
 		simulationTimeLeft += frameInfo.frameTime;
 
 		while (simulationTimeLeft >= PHYSICS_TICK)
@@ -26,51 +23,46 @@ namespace Minimal
 
 			/* Physics Update */
 
-			for (Entity e = 0; e < m_ecs.getEntityCount(); e++)
-			{
-				//Scheduler::QueueTask([&, e]()
-					//{
-						if (m_ecs.hasComponent<RigidbodyComponent>(e) && m_ecs.hasComponent<ColliderComponent>(e))
-						{
-							TransformComponent& transform = m_ecs.getComponent<TransformComponent>(e);
-							RigidbodyComponent& rb = m_ecs.getComponent<RigidbodyComponent>(e);
-
-							RigidbodyUtils::ApplyGravity(rb);
-
-							RigidbodyUtils::UpdatePhysics(transform, rb, tickPhysics ? PHYSICS_TICK : 0);
-						}
-					//}, TaskPriority::LOW, counter);
-			}
+			// Bodies integrate independently, so the ranges are spread over the worker threads.
+			// Integration itself only touches the motion state, the properties are read for gravity.
+			integrationBodies.parallelEach(
+				[&](TransformComponent& transform, RigidbodyComponent& rb, const RigidbodyPropertiesComponent& properties, const ColliderComponent&)
+				{
+					RigidbodyUtils::ApplyGravity(rb, properties);
 
-			//Scheduler::WaitForCounter(counter);
+					RigidbodyUtils::UpdatePhysics(transform, rb, tickPhysics ? PHYSICS_TICK : 0);
+				});
 
 			/* Collision Detection and Contact Generation */
 
-			for (Entity e1 = 0; e1 < m_ecs.getEntityCount(); e1++)
+			// Gather the bodies once so the pair loop walks a flat array instead of querying the ECS per pair
+			struct CollisionBody
 			{
-				if (!m_ecs.hasComponent<RigidbodyComponent>(e1) || !m_ecs.hasComponent<ColliderComponent>(e1))
-					continue;
-				
-				for (Entity e2 = 0; e2 < m_ecs.getEntityCount(); e2++)
+				Entity entity;
+				const TransformComponent* transform;
+				const ColliderComponent* collider;
+			};
+			std::vector<CollisionBody> bodies;
+			collisionBodies.each(
+				[&](Entity e, const TransformComponent& transform, const RigidbodyComponent&, const ColliderComponent& collider)
 				{
-					if (!m_ecs.hasComponent<RigidbodyComponent>(e2) || !m_ecs.hasComponent<ColliderComponent>(e2))
-						continue;
+					bodies.push_back({ e, &transform, &collider });
+				});
 
-					if (e1 == e2)
+			for (const CollisionBody& bodyA : bodies)
+			{
+				for (const CollisionBody& bodyB : bodies)
+				{
+					if (bodyA.entity == bodyB.entity)
 						continue;
 
-					TransformComponent& transformA = m_ecs.getComponent<TransformComponent>(e1);
-					TransformComponent& transformB = m_ecs.getComponent<TransformComponent>(e2);
-					ColliderComponent& colliderA = m_ecs.getComponent<ColliderComponent>(e1);
-					ColliderComponent& colliderB = m_ecs.getComponent<ColliderComponent>(e2);
-
 					std::vector<ContactPoint> contactPoints;
-					if (GJK(transformA, colliderA, transformB, colliderB, contactPoints))
+					if (GJK(*bodyA.transform, *bodyA.collider, *bodyB.transform, *bodyB.collider, contactPoints))
 					{
 						CollisionData collisionData{};
-						collisionData.entityA = e1;
-						collisionData.entityB = e2;
-						collisionData.colliderPair = CollisionPair(&colliderA, &colliderB);
+						collisionData.entityA = bodyA.entity;
+						collisionData.entityB = bodyB.entity;
+						collisionData.colliderPair = CollisionPair(bodyA.collider, bodyB.collider);
 						collisionData.contacts = contactPoints;
 
 						collisions.push_back(collisionData);
@@ -87,6 +79,8 @@ namespace Minimal
 
 				RigidbodyComponent& bodyA = m_ecs.getComponent<RigidbodyComponent>(entityA);
 				RigidbodyComponent& bodyB = m_ecs.getComponent<RigidbodyComponent>(entityB);
+				const RigidbodyPropertiesComponent& propertiesA = m_ecs.getComponent<const RigidbodyPropertiesComponent>(entityA);
+				const RigidbodyPropertiesComponent& propertiesB = m_ecs.getComponent<const RigidbodyPropertiesComponent>(entityB);
 				const ColliderComponent& colliderA = *collisionData.colliderPair.GetFirst();
 				const ColliderComponent& colliderB = *collisionData.colliderPair.GetSecond();
 				TransformComponent& transformA = m_ecs.getComponent<TransformComponent>(entityA);
@@ -99,10 +93,10 @@ namespace Minimal
 				glm::vec3 initialAngularVelocityA = bodyA.angularVelocity;
 				glm::vec3 initialAngularVelocityB = bodyB.angularVelocity;
 
-				float inverseMassA = RigidbodyUtils::GetInverseMass(bodyA);
-				float inverseMassB = RigidbodyUtils::GetInverseMass(bodyB);
-				glm::mat4 inertiaTensorA = RigidbodyUtils::GetInertiaTensor(transformA, colliderA, bodyA);
-				glm::mat4 inertiaTensorB = RigidbodyUtils::GetInertiaTensor(transformB, colliderB, bodyB);
+				float inverseMassA = RigidbodyUtils::GetInverseMass(propertiesA);
+				float inverseMassB = RigidbodyUtils::GetInverseMass(propertiesB);
+				glm::mat4 inertiaTensorA = RigidbodyUtils::GetInertiaTensor(transformA, colliderA, propertiesA);
+				glm::mat4 inertiaTensorB = RigidbodyUtils::GetInertiaTensor(transformB, colliderB, propertiesB);
 
 				for (const ContactPoint& contact : collisionData.contacts)
 				{
@@ -121,7 +115,7 @@ namespace Minimal
 						continue;
 
 					// Calculate restitution (bounciness)
-					float e = min(bodyA.bounciness, bodyB.bounciness);
+					float e = min(propertiesA.bounciness, propertiesB.bounciness);
 
 					// Calculate impulse scalar
 					float j = -(1 + e) * velocityAlongNormal;
@@ -131,8 +125,8 @@ namespace Minimal
 
 					// Apply impulse
 					glm::vec3 impulse = contact.normal * j;
-					RigidbodyUtils::ApplyImpulse(transformA, colliderA, bodyA, -impulse, contact.location);
-					RigidbodyUtils::ApplyImpulse(transformB, colliderB, bodyB, impulse, contact.location);
+					RigidbodyUtils::ApplyImpulse(transformA, colliderA, bodyA, propertiesA, -impulse, contact.location);
+					RigidbodyUtils::ApplyImpulse(transformB, colliderB, bodyB, propertiesB, impulse, contact.location);
 
 					/* Friction */
 
@@ -150,8 +144,8 @@ namespace Minimal
 
 					// Determine whether to use static or dynamic friction and scale max impulse
 					float coefficient = tangentialVelocity == glm::vec3(0, 0, 0) ?
-						sqrt(pow(bodyA.staticFriction, 2) + pow(bodyB.staticFriction, 2))
-						: sqrt(pow(bodyA.dynamicFriction, 2) + pow(bodyB.dynamicFriction, 2));
+						sqrt(pow(propertiesA.staticFriction, 2) + pow(propertiesB.staticFriction, 2))
+						: sqrt(pow(propertiesA.dynamicFriction, 2) + pow(propertiesB.dynamicFriction, 2));
 					float maxFrictionImpulse = coefficient * j;
 
 					glm::vec3 rA_cross_t = glm::cross(rA, tangentialVelocity);
@@ -166,8 +160,8 @@ namespace Minimal
 					glm::vec3 frictionImpulse = tangentialVelocity * frictionImpulseMagnitude;
 
 					// Apply friction impulse
-					RigidbodyUtils::ApplyImpulse(transformA, colliderA, bodyA, -frictionImpulse, contact.location);
-					RigidbodyUtils::ApplyImpulse(transformB, colliderB, bodyB, frictionImpulse, contact.location);
+					RigidbodyUtils::ApplyImpulse(transformA, colliderA, bodyA, propertiesA, -frictionImpulse, contact.location);
+					RigidbodyUtils::ApplyImpulse(transformB, colliderB, bodyB, propertiesB, frictionImpulse, contact.location);
 
 					// Positional correction to prevent sinking
 					const float percent = 0.2f; // Usually 20% to 80%
@@ -86,12 +86,18 @@ struct CollisionData
 namespace Minimal {
     class PhysicsSystem : public System {
 	private:
-		Counter* counter;
-
 		std::unordered_map<CollisionPair, std::vector<ContactPoint>> cachedContacts;
 
 		bool tickPhysics = true;
 
+		// Frame time not yet consumed by fixed physics ticks. Per system, so every world keeps its own.
+		float simulationTimeLeft = 0;
+
+		// Bodies that are integrated and bodies that take part in collision detection. Detection only reads, so
+		// gathering the bodies does not stamp them as changed; contact resolution writes through getComponent.
+		Query<TransformComponent, RigidbodyComponent, const RigidbodyPropertiesComponent, const ColliderComponent> integrationBodies;
+		Query<const TransformComponent, const RigidbodyComponent, const ColliderComponent> collisionBodies;
+
     public:
         PhysicsSystem(ECSCoordinator& ecs);
 
@@ -99,8 +105,6 @@ namespace Minimal {
 
         PhysicsSystem& operator=(const PhysicsSystem&) = delete;
 
-        void initialize();
-
         void update(FrameInfo& frameInfo);
 
 	private:
@@ -82,55 +82,55 @@ namespace Minimal
 			rigidbody.netTorque = glm::vec3();
 		}
 
-		void RigidbodyUtils::AddForce(RigidbodyComponent& rigidbody, glm::vec3 force)
+		void RigidbodyUtils::AddForce(RigidbodyComponent& rigidbody, const RigidbodyPropertiesComponent& properties, glm::vec3 force)
 		{
-			if (rigidbody.isStatic)
+			if (properties.isStatic)
 				return;
 
 			rigidbody.netForce += force;
 		}
-		void RigidbodyUtils::AddTorque(RigidbodyComponent& rigidbody, glm::vec3 axisAngle)
+		void RigidbodyUtils::AddTorque(RigidbodyComponent& rigidbody, const RigidbodyPropertiesComponent& properties, glm::vec3 axisAngle)
 		{
-			if (rigidbody.isStatic)
+			if (properties.isStatic)
 				return;
 
 			rigidbody.netTorque += axisAngle;
 		}
-		void RigidbodyUtils::ApplyGravity(RigidbodyComponent& rigidbody)
+		void RigidbodyUtils::ApplyGravity(RigidbodyComponent& rigidbody, const RigidbodyPropertiesComponent& properties)
 		{
-			AddForce(rigidbody, rigidbody.gravity);
+			AddForce(rigidbody, properties, properties.gravity);
 		}
 
-		void RigidbodyUtils::ApplyImpulse(const TransformComponent& transform, const ColliderComponent& collider, RigidbodyComponent& rigidbody, const glm::vec3& impulse, const glm::vec3& location)
+		void RigidbodyUtils::ApplyImpulse(const TransformComponent& transform, const ColliderComponent& collider, RigidbodyComponent& rigidbody, const RigidbodyPropertiesComponent& properties, const glm::vec3& impulse, const glm::vec3& location)
 		{
-			if (rigidbody.isStatic)
+			if (properties.isStatic)
 				return;
 
 			// Apply linear impulse
-			rigidbody.velocity += impulse / rigidbody.mass;
+			rigidbody.velocity += impulse / properties.mass;
 
 			glm::vec3 r = location - ColliderUtils::GetCenter(transform, collider);
 
 			// Apply angular impulse
 			glm::vec4 cross = glm::vec4(glm::cross(r, impulse), 0);
-			glm::mat4 inv = glm::inverse(GetInertiaTensor(transform, collider, rigidbody));
+			glm::mat4 inv = glm::inverse(GetInertiaTensor(transform, collider, properties));
 			glm::vec3 delta = (glm::vec3)(inv * cross);
 			rigidbody.angularVelocity += delta;
 		}
 
-		float RigidbodyUtils::GetMass(const RigidbodyComponent& rigidbody)
+		float RigidbodyUtils::GetMass(const RigidbodyPropertiesComponent& properties)
 		{
 			// Static bodies should be treated as having infinite mass
-			return rigidbody.isStatic ? FLT_MAX : rigidbody.mass;
+			return properties.isStatic ? FLT_MAX : properties.mass;
 		}
-		float RigidbodyUtils::GetInverseMass(const RigidbodyComponent& rigidbody)
+		float RigidbodyUtils::GetInverseMass(const RigidbodyPropertiesComponent& properties)
 		{
-			return rigidbody.isStatic ? 0 : 1.0f / rigidbody.mass;
+			return properties.isStatic ? 0 : 1.0f / properties.mass;
 		}
 
-		glm::mat4 RigidbodyUtils::GetInertiaTensor(const TransformComponent& transform, const ColliderComponent& collider, const RigidbodyComponent& rigidbody)
+		glm::mat4 RigidbodyUtils::GetInertiaTensor(const TransformComponent& transform, const ColliderComponent& collider, const RigidbodyPropertiesComponent& properties)
 		{
-			glm::mat4 inertiaTensor = ColliderUtils::GetInertiaTensor(collider, rigidbody.mass);
+			glm::mat4 inertiaTensor = ColliderUtils::GetInertiaTensor(collider, properties.mass);
 
 			return TransformUtils::GetRotationMatrix(transform) * (inertiaTensor * glm::transpose(TransformUtils::GetRotationMatrix(transform)));
 		}
@@ -26,15 +26,15 @@ namespace Minimal
 	{
 		void UpdatePhysics(TransformComponent& transform, RigidbodyComponent& rigidbody, float deltaTime);
 
-		void AddForce(RigidbodyComponent& rigidbody, glm::vec3 force);
-		void AddTorque(RigidbodyComponent& rigidbody, glm::vec3 axisAngle);
-		void ApplyGravity(RigidbodyComponent& rigidbody);
+		void AddForce(RigidbodyComponent& rigidbody, const RigidbodyPropertiesComponent& properties, glm::vec3 force);
+		void AddTorque(RigidbodyComponent& rigidbody, const RigidbodyPropertiesComponent& properties, glm::vec3 axisAngle);
+		void ApplyGravity(RigidbodyComponent& rigidbody, const RigidbodyPropertiesComponent& properties);
 
-		void ApplyImpulse(const TransformComponent& transform, const ColliderComponent& collider, RigidbodyComponent& rigidbody, const glm::vec3& impulse, const glm::vec3& location);
+		void ApplyImpulse(const TransformComponent& transform, const ColliderComponent& collider, RigidbodyComponent& rigidbody, const RigidbodyPropertiesComponent& properties, const glm::vec3& impulse, const glm::vec3& location);
 
-		float GetMass(const RigidbodyComponent& rigidbody);
-		float GetInverseMass(const RigidbodyComponent& rigidbody);
+		float GetMass(const RigidbodyPropertiesComponent& properties);
+		float GetInverseMass(const RigidbodyPropertiesComponent& properties);
 
-		glm::mat4 GetInertiaTensor(const TransformComponent& transform, const ColliderComponent& collider, const RigidbodyComponent& rigidbody);
+		glm::mat4 GetInertiaTensor(const TransformComponent& transform, const ColliderComponent& collider, const RigidbodyPropertiesComponent& properties);
 	}
 }
\ No newline at end of file
@@ -21,7 +21,10 @@ namespace Minimal {
                                        VulkanDevice &device,
                                        VkRenderPass renderPass,
                                        VkDescriptorSetLayout globalSetLayout) : System(ecs),
-                                                                                m_device{device} {
+                                                                                m_device{device},
+                                                                                m_lights(ecs),
+                                                                                m_visibleLights(ecs) {
+        m_access.read<PointLightComponent>().write<TransformComponent>();
         createPipelineLayout(globalSetLayout);
         createPipeline(renderPass);
     }
@@ -73,13 +76,7 @@ namespace Minimal {
         );
         int lightIndex = 0;
 
-        for (Entity e = 0; e < m_ecs.getEntityCount(); e++) {
-            if (!m_ecs.hasComponent<PointLightComponent>(e))
-                continue;
-
-            auto &transform = m_ecs.getComponent<TransformComponent>(e);
-            auto &pointLight = m_ecs.getComponent<PointLightComponent>(e);
-
+        m_lights.each([&](TransformComponent &transform, const PointLightComponent &pointLight) {
             assert(lightIndex< MAX_LIGHTS && "Point lights exceed maximum specified");
 
             // update light position
@@ -90,27 +87,22 @@ namespace Minimal {
             frameInfo.ubo.pointLights[lightIndex].color = glm::vec4(pointLight.color, pointLight.lightIntensity);
 
             lightIndex++;
-        }
+        });
 
         frameInfo.ubo.numLights = lightIndex;
     }
 
     void PointLightSystem::render(FrameInfo &frameInfo) {
         // sort lights
-        std::map<float, Entity> sortedLights;
+        std::map<float, std::pair<const TransformComponent *, const PointLightComponent *> > sortedLights;
 
 
-        for (Entity e = 0; e < m_ecs.getEntityCount(); e++) {
-            if (!m_ecs.hasComponent<PointLightComponent>(e))
-                continue;
-
-            auto &transform = m_ecs.getComponent<TransformComponent>(e);
-
+        m_visibleLights.each([&](const TransformComponent &transform, const PointLightComponent &pointLight) {
             // calculate distance
             auto offset = frameInfo.camera->getPosition() - transform.position;
             float distanceSquared = dot(offset, offset);
-            sortedLights[distanceSquared] = e;
-        }
+            sortedLights[distanceSquared] = {&transform, &pointLight};
+        });
         // for (auto& kv : frameInfo.gameObjects)
         // {
         //     auto& obj = kv.second;
@@ -138,8 +130,8 @@ namespace Minimal {
         // iterate through sorted lights in reverse order
         for (auto it = sortedLights.rbegin(); it != sortedLights.rend(); ++it) {
             // auto& obj = frameInfo.gameObjects.at(it->second);
-            auto &transform = m_ecs.getComponent<TransformComponent>(it->second);
-            auto &pointLight = m_ecs.getComponent<PointLightComponent>(it->second);
+            auto &transform = *it->second.first;
+            auto &pointLight = *it->second.second;
 
             PointLightPushConstants push{};
 
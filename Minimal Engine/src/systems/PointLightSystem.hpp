@@ -29,6 +29,10 @@ namespace Minimal {
 
         VulkanDevice &m_device;
 
+        // update() moves the lights, render() only reads them and must not stamp their transforms as changed
+        Query<TransformComponent, const PointLightComponent> m_lights;
+        Query<const TransformComponent, const PointLightComponent> m_visibleLights;
+
         std::unique_ptr<VulkanPipeline> m_pipeline;
         VkPipelineLayout m_pipelineLayout;
     };
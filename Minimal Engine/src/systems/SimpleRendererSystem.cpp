@@ -16,7 +16,10 @@ namespace Minimal {
                                                VulkanDevice &device,
                                                VkRenderPass renderPass,
                                                VkDescriptorSetLayout globalSetLayout) : System(ecs),
-                                                                                        m_device{device} {
+                                                                                        m_device{device},
+                                                                                        m_renderables(ecs),
+                                                                                        m_hierarchyRenderables(ecs) {
+        m_access.read<TransformComponent, WorldTransformComponent, MeshRendererComponent>();
         createPipelineLayout(globalSetLayout);
         createPipeline(renderPass);
     }
@@ -71,17 +74,33 @@ namespace Minimal {
             nullptr
         );
 
-        for (Entity e = 0; e < m_ecs.getEntityCount(); ++e) {
-            if (!m_ecs.hasComponent<MeshRendererComponent>(e))
-                continue;
-
-            auto &transform = m_ecs.getComponent<TransformComponent>(e);
-            auto model = m_ecs.getComponent<MeshRendererComponent>(e).mesh;
-
+        // Refresh the cached matrices of every transform written since the last frame
+        std::uint32_t seenVersion = m_ecs.advanceChangeVersion();
+        m_renderables.view()
+                .changedSince<TransformComponent>(m_lastRenderVersion)
+                .each([&](Entity entity, const TransformComponent &transform, const MeshRendererComponent &) {
+                    updateCachedMatrices(entity, transform);
+                });
+        // Hierarchy nodes also move with their ancestors
+        m_hierarchyRenderables.view()
+                .changedSince<WorldTransformComponent>(m_lastRenderVersion)
+                .each([&](Entity entity, const WorldTransformComponent &worldTransform, const MeshRendererComponent &) {
+                    updateCachedMatrices(entity, worldTransform);
+                });
+        m_lastRenderVersion = seenVersion;
+
+        m_renderables.each([&](Entity entity, const TransformComponent &transform, const MeshRendererComponent &meshRenderer) {
+            auto &model = meshRenderer.mesh;
+
+            // Entities that joined the system without a transform change have no cache entry yet
+            if (getCachedMatrices(entity).entity != entity)
+                updateCachedMatrices(entity, transform);
+
+            const CachedModelMatrices &cached = getCachedMatrices(entity);
             SimplePushConstantData push{};
 
-            push.modelMatrix = transform.mat4();
-            push.normalMatrix = transform.normalMatrix();
+            push.modelMatrix = cached.modelMatrix;
+            push.normalMatrix = cached.normalMatrix;
 
             vkCmdPushConstants(frameInfo.commandBuffer,
                                m_pipelineLayout,
@@ -91,8 +110,34 @@ namespace Minimal {
                                &push);
             model->bind(frameInfo.commandBuffer);
             model->draw(frameInfo.commandBuffer);
-        }
+        });
     }
 
     void SimpleRendererSystem::update(FrameInfo &frameInfo) {}
+
+    SimpleRendererSystem::CachedModelMatrices &SimpleRendererSystem::getCachedMatrices(Entity entity) {
+        std::uint32_t index = entityIndex(entity);
+        if (index >= m_cachedMatrices.size())
+            m_cachedMatrices.resize(index + 1);
+        return m_cachedMatrices[index];
+    }
+
+    void SimpleRendererSystem::updateCachedMatrices(Entity entity, const TransformComponent &transform) {
+        if (m_ecs.hasComponent<WorldTransformComponent>(entity)) {
+            updateCachedMatrices(entity, m_ecs.getComponent<const WorldTransformComponent>(entity));
+            return;
+        }
+
+        CachedModelMatrices &cached = getCachedMatrices(entity);
+        cached.entity = entity;
+        cached.modelMatrix = transform.mat4();
+        cached.normalMatrix = transform.normalMatrix();
+    }
+
+    void SimpleRendererSystem::updateCachedMatrices(Entity entity, const WorldTransformComponent &worldTransform) {
+        CachedModelMatrices &cached = getCachedMatrices(entity);
+        cached.entity = entity;
+        cached.modelMatrix = worldTransform.matrix;
+        cached.normalMatrix = worldTransform.normalMatrix();
+    }
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 
 #include "../rendering/vulkan/VulkanDevice.hpp"
 #include "FrameInfo.hpp"
@@ -23,13 +24,33 @@ namespace Minimal {
         void update(FrameInfo &frameInfo) override;
 
     private:
+        struct CachedModelMatrices {
+            Entity entity = INVALID_ENTITY;
+            glm::mat4 modelMatrix{1.0f};
+            glm::mat4 normalMatrix{1.0f};
+        };
+
+        CachedModelMatrices &getCachedMatrices(Entity entity);
+
+        void updateCachedMatrices(Entity entity, const TransformComponent &transform);
+
+        void updateCachedMatrices(Entity entity, const WorldTransformComponent &worldTransform);
+
         void createPipelineLayout(VkDescriptorSetLayout globalSetLayout);
 
         void createPipeline(VkRenderPass renderPass);
 
         VulkanDevice &m_device;
 
+        Query<const TransformComponent, const MeshRendererComponent> m_renderables;
+        // Renderables placed in a hierarchy, drawn with the world matrix computed by TransformSystem
+        Query<const WorldTransformComponent, const MeshRendererComponent> m_hierarchyRenderables;
+
         std::unique_ptr<VulkanPipeline> m_pipeline;
         VkPipelineLayout m_pipelineLayout;
+
+        // Model matrices indexed by entity index, only recomputed when the transform changed
+        std::vector<CachedModelMatrices> m_cachedMatrices;
+        std::uint32_t m_lastRenderVersion = 0;
     };
 }
@@ -8,6 +8,4 @@ namespace Minimal {
     System::System(ECSCoordinator &ecs)
         : m_ecs(ecs) {
     }
-
-    System::~System() = default;
 }
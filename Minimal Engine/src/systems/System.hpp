@@ -5,17 +5,22 @@
 
 #include "FrameInfo.hpp"
 #include "ecs/ECSCoordinator.hpp"
+#include "ecs/Query.hpp"
 
 namespace Minimal {
     class System {
     public:
         explicit System(ECSCoordinator &ecs);
 
-        virtual ~System();
+        virtual ~System() = default;
 
         virtual void update(FrameInfo &frameInfo) = 0;
 
+        // Components read and written by update(), used to run it concurrently with other systems.
+        const ComponentAccess &getAccess() const { return m_access; }
+
     protected:
         ECSCoordinator &m_ecs;
+        ComponentAccess m_access{};
     };
 }
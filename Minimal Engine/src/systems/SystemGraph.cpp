@@ -0,0 +1,126 @@
+#include "SystemGraph.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+#include "scheduler/Scheduler.h"
+
+namespace Minimal {
+    SystemGraph::SystemGraph(ECSCoordinator &ecs)
+        : m_ecs(ecs) {
+    }
+
+    SystemGraph::~SystemGraph() {
+        if (m_counter != nullptr)
+            Scheduler::DestroyCounter(m_counter);
+    }
+
+    void SystemGraph::addSystem(System &system) {
+        assert(std::find(m_systems.begin(), m_systems.end(), &system) == m_systems.end() && "System added twice.");
+        m_systems.push_back(&system);
+        m_isDirty = true;
+    }
+
+    void SystemGraph::addDependency(System &before, System &after) {
+        m_explicitDependencies.emplace_back(indexOf(before), indexOf(after));
+        m_isDirty = true;
+    }
+
+    void SystemGraph::update(FrameInfo &frameInfo) {
+        if (m_isDirty)
+            build();
+        if (m_nodes.empty())
+            return;
+
+        if (m_counter == nullptr)
+            m_counter = Scheduler::CreateCounter();
+
+        m_frameInfo = &frameInfo;
+        for (std::size_t i = 0; i < m_nodes.size(); ++i) {
+            m_remainingDependencies[i].store(m_nodes[i].dependencyCount, std::memory_order_relaxed);
+        }
+
+        for (std::size_t i = 0; i < m_nodes.size(); ++i) {
+            if (m_nodes[i].dependencyCount == 0)
+                queueSystem(i);
+        }
+
+        Scheduler::WaitForCounter(m_counter);
+        m_frameInfo = nullptr;
+    }
+
+    void SystemGraph::build() {
+        const std::size_t count = m_systems.size();
+        m_nodes.assign(count, Node{});
+
+        std::vector<std::vector<bool> > edges(count, std::vector<bool>(count, false));
+        for (const auto &[before, after] : m_explicitDependencies) {
+            assert(before != after && "System cannot depend on itself.");
+            edges[before][after] = true;
+        }
+        // Conflicting systems run in the order they were added unless an explicit dependency says otherwise
+        for (std::size_t after = 0; after < count; ++after) {
+            for (std::size_t before = 0; before < after; ++before) {
+                if (!edges[after][before]
+                    && m_systems[before]->getAccess().conflictsWith(m_systems[after]->getAccess()))
+                    edges[before][after] = true;
+            }
+        }
+
+        for (std::size_t before = 0; before < count; ++before) {
+            m_nodes[before].system = m_systems[before];
+            for (std::size_t after = 0; after < count; ++after) {
+                if (edges[before][after]) {
+                    m_nodes[before].dependents.push_back(after);
+                    ++m_nodes[after].dependencyCount;
+                }
+            }
+        }
+
+#ifndef NDEBUG
+        // Every system must become ready eventually, which fails if the explicit dependencies form a cycle
+        std::vector<std::uint32_t> remaining(count);
+        std::vector<std::size_t> ready;
+        for (std::size_t i = 0; i < count; ++i) {
+            remaining[i] = m_nodes[i].dependencyCount;
+            if (remaining[i] == 0)
+                ready.push_back(i);
+        }
+        std::size_t visited = 0;
+        while (!ready.empty()) {
+            std::size_t index = ready.back();
+            ready.pop_back();
+            ++visited;
+            for (std::size_t dependent : m_nodes[index].dependents) {
+                if (--remaining[dependent] == 0)
+                    ready.push_back(dependent);
+            }
+        }
+        assert(visited == count && "System dependencies form a cycle.");
+#endif
+
+        m_remainingDependencies = std::make_unique<std::atomic<std::uint32_t>[]>(count);
+        m_isDirty = false;
+    }
+
+    void SystemGraph::queueSystem(std::size_t index) {
+        Scheduler::QueueTask([this, index]() { runSystem(index); }, TaskPriority::HIGH, m_counter);
+    }
+
+    void SystemGraph::runSystem(std::size_t index) {
+        const Node &node = m_nodes[index];
+        m_ecs.withAccess(node.system->getAccess(), [&]() { node.system->update(*m_frameInfo); });
+
+        // Queued while this task still holds the counter, so the frame cannot complete in between
+        for (std::size_t dependent : node.dependents) {
+            if (m_remainingDependencies[dependent].fetch_sub(1, std::memory_order_acq_rel) == 1)
+                queueSystem(dependent);
+        }
+    }
+
+    std::size_t SystemGraph::indexOf(const System &system) const {
+        auto it = std::find(m_systems.begin(), m_systems.end(), &system);
+        assert(it != m_systems.end() && "System has not been added to the graph.");
+        return static_cast<std::size_t>(it - m_systems.begin());
+    }
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "FrameInfo.hpp"
+#include "System.hpp"
+#include "scheduler/Counter.h"
+
+namespace Minimal {
+    // Runs the update() of a set of systems as scheduler tasks. A system waits for every system added before it
+    // whose access set conflicts with its own, and for the systems it was explicitly ordered after. Everything
+    // else runs concurrently, each system holding its access set for the duration of its update.
+    class SystemGraph {
+    public:
+        explicit SystemGraph(ECSCoordinator &ecs);
+
+        ~SystemGraph();
+
+        SystemGraph(const SystemGraph &) = delete;
+
+        SystemGraph &operator=(const SystemGraph &) = delete;
+
+        void addSystem(System &system);
+
+        // Makes after wait for before even if their access sets do not conflict.
+        void addDependency(System &before, System &after);
+
+        // Updates every system and returns once all of them are done. Must be called from a scheduler task.
+        void update(FrameInfo &frameInfo);
+
+    private:
+        struct Node {
+            System *system;
+            // Systems that wait for this one
+            std::vector<std::size_t> dependents;
+            std::uint32_t dependencyCount;
+        };
+
+        void build();
+
+        void queueSystem(std::size_t index);
+
+        void runSystem(std::size_t index);
+
+        std::size_t indexOf(const System &system) const;
+
+        ECSCoordinator &m_ecs;
+
+        std::vector<System *> m_systems{};
+        std::vector<std::pair<std::size_t, std::size_t> > m_explicitDependencies{};
+
+        // Rebuilt from the systems and dependencies whenever either changes
+        std::vector<Node> m_nodes{};
+        bool m_isDirty = true;
+
+        // Per-frame state shared by the system tasks
+        std::unique_ptr<std::atomic<std::uint32_t>[]> m_remainingDependencies{};
+        FrameInfo *m_frameInfo = nullptr;
+        Counter *m_counter = nullptr;
+    };
+}
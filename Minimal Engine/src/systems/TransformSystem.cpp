@@ -0,0 +1,198 @@
+#include "TransformSystem.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <tuple>
+
+#include "scheduler/Scheduler.h"
+
+namespace Minimal {
+    TransformSystem::TransformSystem(ECSCoordinator &ecs, bool parallel)
+        : System(ecs), m_parallel(parallel), m_hierarchy(ecs) {
+        m_access.read<TransformComponent, HierarchyComponent>().write<WorldTransformComponent>();
+    }
+
+    void TransformSystem::update(FrameInfo &frameInfo) {
+        // Advanced here and not per frame on purpose, the renderer keeps its own cut point the same way
+        const std::uint32_t seenVersion = m_ecs.advanceChangeVersion();
+
+        // A recycled entity keeps its index but is only noticed here because adding a component stamps it with the
+        // current version (markAdded, or the version instantiate stamps) and so reports its hierarchy as changed
+        bool rebuilt = m_hierarchy.size() != m_nodes.size() || hierarchyChangedSince(m_lastVersion);
+        if (rebuilt)
+            rebuild();
+
+        // Local matrices of the nodes whose transform changed, of every node after a rebuild. Change tracking can
+        // report unchanged neighbours as well, so only nodes whose matrix actually differs dirty their subtree.
+        // An entity the cached nodes do not know marks them stale instead, should an add path miss the stamp.
+        bool stale = false;
+        auto refresh = [&](Entity entity, const TransformComponent &transform, const HierarchyComponent &,
+                           const WorldTransformComponent &) {
+            const std::uint32_t index = entityIndex(entity);
+            const std::uint32_t node = index < m_nodeOf.size() ? m_nodeOf[index] : NO_NODE;
+            if (node == NO_NODE || m_nodes[node].entity != entity) {
+                stale = true;
+                return;
+            }
+            const glm::mat4 local = transform.mat4();
+            if (local != m_localMatrices[node])
+                m_dirty[node] = 1;
+            m_localMatrices[node] = local;
+        };
+        if (!rebuilt) {
+            m_hierarchy.view().changedSince<TransformComponent>(m_lastVersion).each(refresh);
+            if (stale) {
+                rebuild();
+                rebuilt = true;
+            }
+        }
+        if (rebuilt) {
+            stale = false;
+            m_hierarchy.each(refresh);
+            assert(!stale && "Rebuilt transform nodes do not match the hierarchy query.");
+        }
+
+        if (m_ranges.size() <= 1) {
+            propagate(0, m_nodes.size());
+        } else {
+            Counter *counter = Scheduler::CreateCounter();
+            for (const auto &[begin, end] : m_ranges) {
+                Scheduler::QueueTask([this, begin = begin, end = end]() { propagate(begin, end); },
+                                     TaskPriority::HIGH, counter);
+            }
+            Scheduler::WaitForCounter(counter);
+            Scheduler::DestroyCounter(counter);
+        }
+
+        // Written back in one place, tasks of different subtrees may share a chunk and its change version
+        for (std::size_t i = 0; i < m_nodes.size(); ++i) {
+            if (!m_dirty[i])
+                continue;
+            m_ecs.getComponent<WorldTransformComponent>(m_nodes[i].entity).matrix = m_worldMatrices[i];
+            m_dirty[i] = 0;
+        }
+
+        m_lastVersion = seenVersion;
+    }
+
+    bool TransformSystem::hierarchyChangedSince(std::uint32_t version) {
+        bool changed = false;
+        m_hierarchy.view().changedSince<HierarchyComponent>(version).each(
+            [&](const TransformComponent &, const HierarchyComponent &, const WorldTransformComponent &) {
+                changed = true;
+            });
+        return changed;
+    }
+
+    void TransformSystem::rebuild() {
+        std::vector<Entity> entities;
+        std::vector<Entity> parentEntities;
+        m_hierarchy.each([&](Entity entity, const TransformComponent &, const HierarchyComponent &hierarchy,
+                             const WorldTransformComponent &) {
+            entities.push_back(entity);
+            parentEntities.push_back(hierarchy.parent);
+        });
+        const std::size_t count = entities.size();
+
+        std::uint32_t highestIndex = 0;
+        for (Entity entity : entities) {
+            highestIndex = std::max(highestIndex, entityIndex(entity));
+        }
+        m_nodeOf.assign(count == 0 ? 0 : static_cast<std::size_t>(highestIndex) + 1, NO_NODE);
+        for (std::size_t i = 0; i < count; ++i) {
+            m_nodeOf[entityIndex(entities[i])] = static_cast<std::uint32_t>(i);
+        }
+
+        // Parents that are dead or not part of a hierarchy leave the node a root
+        std::vector<std::uint32_t> parents(count, NO_NODE);
+        for (std::size_t i = 0; i < count; ++i) {
+            const Entity parent = parentEntities[i];
+            if (parent == INVALID_ENTITY || entityIndex(parent) >= m_nodeOf.size())
+                continue;
+            const std::uint32_t node = m_nodeOf[entityIndex(parent)];
+            if (node != NO_NODE && entities[node] == parent)
+                parents[i] = node;
+        }
+
+        // Depth and root of every node, walking up to the first node that is already known
+        constexpr std::uint32_t UNVISITED = UINT32_MAX;
+        constexpr std::uint32_t VISITING = UINT32_MAX - 1;
+        std::vector<std::uint32_t> depths(count, UNVISITED);
+        std::vector<std::uint32_t> roots(count);
+        std::vector<std::uint32_t> chain;
+        for (std::uint32_t i = 0; i < count; ++i) {
+            for (std::uint32_t node = i; depths[node] == UNVISITED; node = parents[node]) {
+                depths[node] = VISITING;
+                chain.push_back(node);
+                if (parents[node] == NO_NODE)
+                    break;
+            }
+
+            while (!chain.empty()) {
+                const std::uint32_t node = chain.back();
+                chain.pop_back();
+                const std::uint32_t parent = parents[node];
+                if (parent == NO_NODE || depths[parent] == VISITING) {
+                    // A parent still being visited closes a cycle, which is cut here
+                    assert(parent == NO_NODE && "Entity hierarchy contains a cycle.");
+                    parents[node] = NO_NODE;
+                    depths[node] = 0;
+                    roots[node] = node;
+                } else {
+                    depths[node] = depths[parent] + 1;
+                    roots[node] = roots[parent];
+                }
+            }
+        }
+
+        std::vector<std::uint32_t> order(count);
+        for (std::uint32_t i = 0; i < count; ++i) {
+            order[i] = i;
+        }
+        std::sort(order.begin(), order.end(), [&](std::uint32_t a, std::uint32_t b) {
+            return std::tie(roots[a], depths[a], a) < std::tie(roots[b], depths[b], b);
+        });
+
+        std::vector<std::uint32_t> positions(count);
+        for (std::uint32_t position = 0; position < count; ++position) {
+            positions[order[position]] = position;
+        }
+
+        m_nodes.resize(count);
+        m_ranges.clear();
+        std::size_t rangeBegin = 0;
+        for (std::uint32_t position = 0; position < count; ++position) {
+            const std::uint32_t node = order[position];
+            m_nodes[position] = {entities[node], parents[node] == NO_NODE ? NO_NODE : positions[parents[node]]};
+            m_nodeOf[entityIndex(entities[node])] = position;
+
+            // Ranges end between root groups once they hold enough nodes
+            const bool lastOfGroup = position + 1 == count || roots[order[position + 1]] != roots[node];
+            if (m_parallel && lastOfGroup && position + 1 - rangeBegin >= ECSCoordinator::DEFAULT_GRAIN_SIZE) {
+                m_ranges.emplace_back(rangeBegin, position + 1);
+                rangeBegin = position + 1;
+            }
+        }
+        if (rangeBegin < count)
+            m_ranges.emplace_back(rangeBegin, count);
+
+        m_localMatrices.resize(count);
+        m_worldMatrices.resize(count);
+        m_dirty.assign(count, 1);
+    }
+
+    void TransformSystem::propagate(std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+            const std::uint32_t parent = m_nodes[i].parent;
+            if (parent == NO_NODE) {
+                if (m_dirty[i])
+                    m_worldMatrices[i] = m_localMatrices[i];
+                continue;
+            }
+
+            m_dirty[i] |= m_dirty[parent];
+            if (m_dirty[i])
+                m_worldMatrices[i] = m_worldMatrices[parent] * m_localMatrices[i];
+        }
+    }
+}
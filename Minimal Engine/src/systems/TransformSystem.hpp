@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "FrameInfo.hpp"
+#include "System.hpp"
+#include "ecs/Components.hpp"
+
+namespace Minimal {
+    // Computes the WorldTransformComponent of every entity with a HierarchyComponent. The nodes are kept in a flat
+    // array, grouped by root and sorted by depth within each group, so one linear pass over it handles parents
+    // before their children. Only nodes whose own or an ancestor's TransformComponent changed are recomputed.
+    // The array is rebuilt when nodes join or leave a hierarchy or change their parent.
+    class TransformSystem : public System {
+    public:
+        // With parallel set, the pass is split into scheduler tasks of whole root subtrees.
+        explicit TransformSystem(ECSCoordinator &ecs, bool parallel = false);
+
+        TransformSystem(const TransformSystem &) = delete;
+
+        TransformSystem &operator=(const TransformSystem &) = delete;
+
+        void update(FrameInfo &frameInfo) override;
+
+    private:
+        static constexpr std::uint32_t NO_NODE = UINT32_MAX;
+
+        struct Node {
+            Entity entity;
+            // Index of the parent node, NO_NODE for roots
+            std::uint32_t parent;
+        };
+
+        bool hierarchyChangedSince(std::uint32_t version);
+
+        void rebuild();
+
+        void propagate(std::size_t begin, std::size_t end);
+
+        bool m_parallel;
+
+        Query<const TransformComponent, const HierarchyComponent, const WorldTransformComponent> m_hierarchy;
+
+        // Parallel arrays in pass order
+        std::vector<Node> m_nodes{};
+        std::vector<glm::mat4> m_localMatrices{};
+        std::vector<glm::mat4> m_worldMatrices{};
+        // Set for nodes whose world matrix has to be recomputed, bytes so tasks can write their own ranges
+        std::vector<std::uint8_t> m_dirty{};
+
+        // Node of every entity, indexed by entity index
+        std::vector<std::uint32_t> m_nodeOf{};
+        // Node ranges holding whole subtrees, one per task
+        std::vector<std::pair<std::size_t, std::size_t> > m_ranges{};
+
+        std::uint32_t m_lastVersion = 0;
+    };
+}